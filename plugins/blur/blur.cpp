@@ -0,0 +1,618 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "blur.h"
+#include "lowpower.h"
+#include "memoryaccounting.h"
+#include "powerprofile.h"
+#include "roundedrect.h"
+#include "windowcorners.h"
+
+#include <KConfigGroup>
+
+#include <QMatrix4x4>
+#include <QtMath>
+
+#include <xcb/xcb.h>
+
+// {iterations, offset} for BlurStrength 1 to 15, from light to heavy.
+static const struct {
+    int iterations;
+    float offset;
+} s_strengths[] = {
+    {1, 1.0f}, {1, 2.0f},
+    {2, 2.0f}, {2, 3.0f}, {2, 4.0f},
+    {3, 2.5f}, {3, 3.5f}, {3, 4.5f}, {3, 5.5f},
+    {4, 3.0f}, {4, 4.0f}, {4, 5.0f}, {4, 6.0f}, {4, 7.0f}, {4, 8.0f}
+};
+
+static const char s_downsampleSource[] =
+    "uniform sampler2D sampler;\n"
+    "uniform HIGHP vec2 halfpixel;\n"
+    "uniform float offset;\n"
+    "\n"
+    "varying HIGHP vec2 texcoord0;\n"
+    "\n"
+    "void main(void)\n"
+    "{\n"
+    "    HIGHP vec2 uv = texcoord0;\n"
+    "    vec4 sum = texture2D(sampler, uv) * 4.0;\n"
+    "    sum += texture2D(sampler, uv - halfpixel * offset);\n"
+    "    sum += texture2D(sampler, uv + halfpixel * offset);\n"
+    "    sum += texture2D(sampler, uv + vec2(halfpixel.x, -halfpixel.y) * offset);\n"
+    "    sum += texture2D(sampler, uv - vec2(halfpixel.x, -halfpixel.y) * offset);\n"
+    "    gl_FragColor = sum / 8.0;\n"
+    "}\n";
+
+static const char s_upsampleSum[] =
+    "    HIGHP vec2 uv = texcoord0;\n"
+    "    vec4 sum = texture2D(sampler, uv + vec2(-halfpixel.x * 2.0, 0.0) * offset);\n"
+    "    sum += texture2D(sampler, uv + vec2(-halfpixel.x, halfpixel.y) * offset) * 2.0;\n"
+    "    sum += texture2D(sampler, uv + vec2(0.0, halfpixel.y * 2.0) * offset);\n"
+    "    sum += texture2D(sampler, uv + vec2(halfpixel.x, halfpixel.y) * offset) * 2.0;\n"
+    "    sum += texture2D(sampler, uv + vec2(halfpixel.x * 2.0, 0.0) * offset);\n"
+    "    sum += texture2D(sampler, uv + vec2(halfpixel.x, -halfpixel.y) * offset) * 2.0;\n"
+    "    sum += texture2D(sampler, uv + vec2(0.0, -halfpixel.y * 2.0) * offset);\n"
+    "    sum += texture2D(sampler, uv + vec2(-halfpixel.x, -halfpixel.y) * offset) * 2.0;\n";
+
+static KWin::GLShader *generateShader(const QByteArray &body)
+{
+    KWin::GLPlatform * const gl = KWin::GLPlatform::instance();
+    QByteArray source;
+    bool modern;
+
+    if (!gl->isGLES()) {
+        modern = gl->glslVersion() >= KWin::kVersionNumber(1, 40);
+        if (modern)
+            source += "#version 140\n\n";
+        source += Cutefish::DesktopPrecision;
+    } else {
+        modern = gl->glslVersion() >= KWin::kVersionNumber(3, 0);
+        if (modern)
+            source += "#version 300 es\n\n";
+        source += Cutefish::GlesPrecision;
+    }
+
+    QByteArray main = body;
+    if (modern) {
+        main.replace("varying ", "in ");
+        main.replace("texture2D(", "texture(");
+        main.replace("gl_FragColor", "fragColor");
+        source += "out vec4 fragColor;\n\n";
+    }
+    source += main;
+
+    return KWin::ShaderManager::instance()->generateCustomShader(KWin::ShaderTrait::MapTexture, QByteArray(), source);
+}
+
+// Appends two triangles covering rect, textured with tex. tex.top() is
+// the texture coordinate at rect.top(), so a negative height flips.
+static void appendQuad(QVector<float> &vertices, QVector<float> &texcoords, const QRectF &rect, const QRectF &tex)
+{
+    const float x0 = rect.left(), y0 = rect.top(), x1 = rect.x() + rect.width(), y1 = rect.y() + rect.height();
+    const float u0 = tex.left(), v0 = tex.top(), u1 = tex.x() + tex.width(), v1 = tex.y() + tex.height();
+
+    vertices << x0 << y0 << x1 << y0 << x1 << y1
+             << x0 << y0 << x1 << y1 << x0 << y1;
+    texcoords << u0 << v0 << u1 << v0 << u1 << v1
+              << u0 << v0 << u1 << v1 << u0 << v1;
+}
+
+static void renderQuads(const QVector<float> &vertices, const QVector<float> &texcoords)
+{
+    KWin::GLVertexBuffer *vbo = KWin::GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setUseColor(false);
+    vbo->setData(vertices.count() / 2, 2, vertices.constData(), texcoords.constData());
+    vbo->render(GL_TRIANGLES);
+}
+
+// One pass of the pyramid: samples source over the whole of target.
+static void renderPass(KWin::GLShader *shader, KWin::GLTexture *source, KWin::GLRenderTarget *target,
+                       const QSize &targetSize, float offset)
+{
+    QMatrix4x4 projection;
+    projection.ortho(0, targetSize.width(), 0, targetSize.height(), 0, 65535);
+
+    shader->setUniform(KWin::GLShader::ModelViewProjectionMatrix, projection);
+    shader->setUniform("halfpixel", QVector2D(0.5 / source->width(), 0.5 / source->height()));
+    shader->setUniform("offset", offset);
+
+    QVector<float> vertices, texcoords;
+    appendQuad(vertices, texcoords, QRectF(QPointF(0, 0), targetSize), QRectF(0, 0, 1, 1));
+
+    KWin::GLRenderTarget::pushRenderTarget(target);
+    source->bind();
+    renderQuads(vertices, texcoords);
+    source->unbind();
+    KWin::GLRenderTarget::popRenderTarget();
+}
+
+BlurEffect::BlurEffect(QObject *, const QVariantList &)
+    : KWin::Effect()
+    , m_settings(new QSettings(QSettings::UserScope, "cutefishos", "theme", this))
+    , m_powerProfile(new Cutefish::PowerProfile(this))
+{
+    m_atom = KWin::effects->announceSupportProperty(QByteArrayLiteral("_KDE_NET_WM_BLUR_BEHIND_REGION"), this);
+    Cutefish::Memory::exportReport();
+
+    reconfigure(ReconfigureAll);
+
+    connect(m_powerProfile, &Cutefish::PowerProfile::changed, this, [this] {
+        reconfigure(ReconfigureAll);
+    });
+
+    connect(KWin::effects, &KWin::EffectsHandler::windowAdded, this, &BlurEffect::slotWindowAdded);
+    Cutefish::trackMaximizeState(this);
+    connect(KWin::effects, &KWin::EffectsHandler::windowDeleted, this, &BlurEffect::slotWindowDeleted);
+    connect(KWin::effects, &KWin::EffectsHandler::propertyNotify, this, &BlurEffect::slotPropertyNotify);
+
+    // Anything that can change what is behind a blurred window.
+    connect(KWin::effects, &KWin::EffectsHandler::windowDamaged, this, &BlurEffect::slotWindowDamaged);
+    connect(KWin::effects, &KWin::EffectsHandler::windowFrameGeometryChanged, this, &BlurEffect::slotWindowGeometryChanged);
+    connect(KWin::effects, &KWin::EffectsHandler::windowAdded, this, &BlurEffect::slotWindowDamaged);
+    connect(KWin::effects, &KWin::EffectsHandler::windowClosed, this, &BlurEffect::slotWindowDamaged);
+    connect(KWin::effects, &KWin::EffectsHandler::windowMinimized, this, &BlurEffect::slotWindowDamaged);
+    connect(KWin::effects, &KWin::EffectsHandler::windowUnminimized, this, &BlurEffect::slotWindowDamaged);
+    connect(KWin::effects, &KWin::EffectsHandler::windowOpacityChanged, this, &BlurEffect::slotWindowDamaged);
+    connect(KWin::effects, &KWin::EffectsHandler::stackingOrderChanged, this, &BlurEffect::invalidateCaches);
+    connect(KWin::effects, &KWin::EffectsHandler::desktopChanged, this, &BlurEffect::invalidateCaches);
+    connect(KWin::effects, &KWin::EffectsHandler::virtualScreenGeometryChanged, this, &BlurEffect::invalidateCaches);
+
+    for (KWin::EffectWindow *w : KWin::effects->stackingOrder())
+        updateBlurRegion(w);
+}
+
+BlurEffect::~BlurEffect()
+{
+    KWin::effects->makeOpenGLContextCurrent();
+
+    for (BlurWindow &info : m_windows)
+        releasePyramid(info);
+
+    delete m_downsampleShader;
+    delete m_upsampleShader;
+    delete m_compositeShader;
+}
+
+bool BlurEffect::supported()
+{
+    return KWin::effects->isOpenGLCompositing()
+            && KWin::GLRenderTarget::supported()
+            && KWin::GLRenderTarget::blitSupported();
+}
+
+bool BlurEffect::enabledByDefault()
+{
+    return supported();
+}
+
+void BlurEffect::reconfigure(ReconfigureFlags flags)
+{
+    Q_UNUSED(flags)
+
+    // Blur is enabled by default and loads with the compositor, so the
+    // scripted effects get the profile even without roundedwindow.
+    Cutefish::handOffLowPower(m_powerProfile->isLowPower());
+
+    KConfigGroup config = KWin::effects->effectConfig(QStringLiteral("cutefishblur"));
+    int strength = qBound(1, config.readEntry("BlurStrength", 15), 15);
+
+    // Fewer levels on battery, the pyramid shrinks with the kernel.
+    if (m_powerProfile->isLowPower())
+        strength = qMin(strength, qBound(1, config.readEntry("LowPowerBlurStrength", 5), 15));
+
+    m_iterations = s_strengths[strength - 1].iterations;
+    m_offset = s_strengths[strength - 1].offset;
+
+    // The first level is already at half resolution, and every level
+    // spreads the kernel by another factor of two.
+    m_expandSize = qCeil(m_offset * (1 << (m_iterations + 1)));
+
+    m_settings->sync();
+    m_frameRadius = Cutefish::FrameRadius * m_settings->value("PixelRatio", 1.0).toReal();
+
+    // The pyramids depend on the iteration count.
+    KWin::effects->makeOpenGLContextCurrent();
+    for (BlurWindow &info : m_windows)
+        releasePyramid(info);
+
+    KWin::effects->addRepaintFull();
+}
+
+bool BlurEffect::provides(Feature feature)
+{
+    return feature == Blur;
+}
+
+bool BlurEffect::isActive() const
+{
+    return !m_windows.isEmpty() && !KWin::effects->isScreenLocked();
+}
+
+#if KWIN_EFFECT_API_VERSION >= 233
+bool BlurEffect::blocksDirectScanout() const
+{
+    // Only windows behind a blurred one are sampled, never one that
+    // covers the whole output.
+    return false;
+}
+#endif
+
+void BlurEffect::slotWindowAdded(KWin::EffectWindow *w)
+{
+    updateBlurRegion(w);
+}
+
+void BlurEffect::slotWindowDeleted(KWin::EffectWindow *w)
+{
+    m_translucentWindows.remove(w);
+
+    // Its last damage can no longer be placed in the stacking order.
+    m_globalDamage += m_pendingDamage.take(w);
+
+    auto it = m_windows.find(w);
+    if (it == m_windows.end())
+        return;
+
+    KWin::effects->makeOpenGLContextCurrent();
+    releasePyramid(it.value());
+    m_windows.erase(it);
+}
+
+void BlurEffect::slotPropertyNotify(KWin::EffectWindow *w, long atom)
+{
+    if (w && atom == m_atom && m_atom)
+        updateBlurRegion(w);
+}
+
+void BlurEffect::updateBlurRegion(KWin::EffectWindow *w)
+{
+    const QByteArray value = m_atom ? w->readProperty(m_atom, XCB_ATOM_CARDINAL, 32) : QByteArray();
+
+    if (value.isNull()) {
+        slotWindowDeleted(w);
+        return;
+    }
+
+    QRegion region;
+    if (value.size() > 0 && value.size() % (4 * sizeof(uint32_t)) == 0) {
+        const uint32_t *cardinals = reinterpret_cast<const uint32_t *>(value.constData());
+        for (int i = 0; i < value.size() / int(sizeof(uint32_t)); i += 4)
+            region += QRect(cardinals[i], cardinals[i + 1], cardinals[i + 2], cardinals[i + 3]);
+    }
+
+    m_windows[w].region = region;
+    w->addRepaintFull();
+}
+
+void BlurEffect::slotWindowDamaged(KWin::EffectWindow *w)
+{
+    if (m_windows.isEmpty() || !w)
+        return;
+
+    // The whole window, shadow included, is cheaper to track than the
+    // exact damage and still leaves static surfaces alone.
+    m_pendingDamage[w] += w->expandedGeometry();
+}
+
+void BlurEffect::slotWindowGeometryChanged(KWin::EffectWindow *w, const QRect &oldGeometry)
+{
+    if (m_windows.isEmpty() || !w)
+        return;
+
+    m_pendingDamage[w] += oldGeometry;
+    m_pendingDamage[w] += w->expandedGeometry();
+}
+
+void BlurEffect::invalidateCaches()
+{
+    for (BlurWindow &info : m_windows)
+        info.cacheValid = false;
+}
+
+QRegion BlurEffect::blurRegion(KWin::EffectWindow *w) const
+{
+    auto it = m_windows.constFind(w);
+    if (it == m_windows.constEnd())
+        return QRegion();
+
+    const QRect contents = w->contentsRect();
+    QRegion region = it->region.isEmpty() ? QRegion(contents)
+                                          : it->region.translated(contents.topLeft()) & contents;
+    return region.translated(w->pos());
+}
+
+QRegion BlurEffect::expand(const QRegion &region) const
+{
+    QRegion expanded;
+    for (const QRect &rect : region)
+        expanded += rect.adjusted(-m_expandSize, -m_expandSize, m_expandSize, m_expandSize);
+    return expanded;
+}
+
+void BlurEffect::prePaintScreen(KWin::ScreenPrePaintData &data, std::chrono::milliseconds presentTime)
+{
+    m_damagedArea = m_globalDamage;
+    m_globalDamage = QRegion();
+
+    KWin::effects->prePaintScreen(data, presentTime);
+}
+
+void BlurEffect::prePaintWindow(KWin::EffectWindow *w, KWin::WindowPrePaintData &data, std::chrono::milliseconds presentTime)
+{
+    KWin::effects->prePaintWindow(w, data, presentTime);
+
+    // Windows are walked bottom to top, so m_damagedArea only holds what
+    // changed below this one.
+    auto it = m_windows.find(w);
+    if (it != m_windows.end()) {
+        const QRegion shape = blurRegion(w);
+        const QRegion expanded = expand(shape);
+
+        // Something changed below, or the window itself moved.
+        if (m_damagedArea.intersects(expanded)
+                || it->cacheRect != (expanded.boundingRect() & KWin::effects->virtualScreenGeometry()))
+            it->cacheValid = false;
+
+        // Recomputing needs everything the kernel reaches to be up to date.
+        if (!shape.isEmpty() && !it->cacheValid)
+            data.paint += expanded;
+    }
+
+    // Other effects animate windows with addRepaint only, there is no
+    // damage: a window being transformed, closed or shown translucent
+    // changes the background of everything above it on each paint.
+    // PAINT_WINDOW_TRANSLUCENT alone says nothing, RoundedWindow sets it
+    // for every rounded window. Fades only show in the paint data, so the
+    // opacity of the last frame stands in for this one's.
+    if (data.mask & PAINT_WINDOW_TRANSFORMED)
+        m_damagedArea += data.paint;
+    else if (w->isDeleted() || w->opacity() < 1.0 || m_translucentWindows.contains(w))
+        m_damagedArea += data.paint & w->expandedGeometry();
+
+    m_damagedArea += m_pendingDamage.take(w);
+}
+
+void BlurEffect::postPaintScreen()
+{
+    // Damage of windows that were not walked this frame.
+    for (const QRegion &damage : qAsConst(m_pendingDamage))
+        m_globalDamage += damage;
+    m_pendingDamage.clear();
+
+    KWin::effects->postPaintScreen();
+}
+
+bool BlurEffect::ensureShaders()
+{
+    if (m_compositeShader)
+        return m_downsampleShader->isValid() && m_upsampleShader->isValid() && m_compositeShader->isValid();
+
+    m_downsampleShader = generateShader(s_downsampleSource);
+
+    QByteArray upsample;
+    upsample += "uniform sampler2D sampler;\n"
+                "uniform HIGHP vec2 halfpixel;\n"
+                "uniform float offset;\n"
+                "\n"
+                "varying HIGHP vec2 texcoord0;\n"
+                "\n"
+                "void main(void)\n"
+                "{\n";
+    upsample += s_upsampleSum;
+    upsample += "    gl_FragColor = sum / 12.0;\n"
+                "}\n";
+    m_upsampleShader = generateShader(upsample);
+
+    // The last upsample pass goes straight to the screen, clipped to the
+    // same rounded rect as the window itself. radii holds the top-left,
+    // top-right, bottom-left and bottom-right radius, 0 where RoundedWindow
+    // keeps the corner square.
+    QByteArray composite;
+    composite += "uniform sampler2D sampler;\n"
+                 "uniform HIGHP vec2 halfpixel;\n"
+                 "uniform float offset;\n"
+                 "uniform HIGHP vec2 sourceSize;\n"
+                 "uniform HIGHP vec4 windowRect;\n"
+                 "uniform vec4 radii;\n"
+                 "uniform float opacity;\n"
+                 "\n"
+                 "varying HIGHP vec2 texcoord0;\n"
+                 "\n";
+    composite += Cutefish::RoundedRectSdf;
+    composite += "\n"
+                 "float cornerRadius(HIGHP vec2 p, HIGHP vec4 rect)\n"
+                 "{\n"
+                 "    HIGHP vec2 center = rect.xy + rect.zw * 0.5;\n"
+                 "    vec2 r = p.y < center.y ? radii.xy : radii.zw;\n"
+                 "    return p.x < center.x ? r.x : r.y;\n"
+                 "}\n"
+                 "\n"
+                 "void main(void)\n"
+                 "{\n";
+    composite += s_upsampleSum;
+    composite += "    HIGHP vec2 p = vec2(texcoord0.x, 1.0 - texcoord0.y) * sourceSize;\n"
+                 "    float coverage = clamp(0.5 - roundedRectSdf(p, windowRect, cornerRadius(p, windowRect)), 0.0, 1.0);\n"
+                 "    gl_FragColor = vec4(sum.rgb / 12.0, coverage * opacity);\n"
+                 "}\n";
+    m_compositeShader = generateShader(composite);
+
+    return m_downsampleShader->isValid() && m_upsampleShader->isValid() && m_compositeShader->isValid();
+}
+
+bool BlurEffect::ensurePyramid(BlurWindow &info, const QSize &size)
+{
+    if (info.size == size && info.textures.count() == m_iterations + 1)
+        return true;
+
+    releasePyramid(info);
+
+    for (int i = 0; i <= m_iterations; ++i) {
+        const QSize levelSize(qMax(1, size.width() >> (i + 1)), qMax(1, size.height() >> (i + 1)));
+
+        KWin::GLTexture *texture = new KWin::GLTexture(GL_RGBA8, levelSize);
+        texture->setFilter(GL_LINEAR);
+        texture->setWrapMode(GL_CLAMP_TO_EDGE);
+
+        KWin::GLRenderTarget *target = new KWin::GLRenderTarget(*texture);
+
+        info.textures.append(texture);
+        info.renderTargets.append(target);
+        Cutefish::Memory::allocated("blur/pyramid", Cutefish::Memory::Gpu, qint64(levelSize.width()) * levelSize.height() * 4);
+
+        if (!target->valid()) {
+            releasePyramid(info);
+            return false;
+        }
+    }
+
+    info.size = size;
+    return true;
+}
+
+void BlurEffect::releasePyramid(BlurWindow &info)
+{
+    for (KWin::GLTexture *texture : qAsConst(info.textures))
+        Cutefish::Memory::freed("blur/pyramid", Cutefish::Memory::Gpu, qint64(texture->width()) * texture->height() * 4);
+
+    qDeleteAll(info.renderTargets);
+    qDeleteAll(info.textures);
+    info.renderTargets.clear();
+    info.textures.clear();
+    info.size = QSize();
+    info.cacheValid = false;
+}
+
+void BlurEffect::drawWindow(KWin::EffectWindow *w, int mask, const QRegion &region, KWin::WindowPaintData &data)
+{
+    // Kept one frame past the end of a fade, the frame at full opacity
+    // changes the background too.
+    if (data.opacity() < 1.0)
+        m_translucentWindows.insert(w);
+    else
+        m_translucentWindows.remove(w);
+
+    auto it = m_windows.find(w);
+
+    if (it != m_windows.end() && data.opacity() > 0.0 && !KWin::effects->isScreenLocked()) {
+        QRegion shape = blurRegion(w);
+        QRegion paintShape;
+        QRect windowRect = w->frameGeometry();
+        const bool transformed = mask & (PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_TRANSFORMED);
+
+        if (transformed) {
+            // Follow scale and translation, e.g. during open animations.
+            const QPoint origin = w->pos();
+            auto transform = [&](const QRect &rect) {
+                return QRectF(origin.x() + data.xTranslation() + (rect.x() - origin.x()) * data.xScale(),
+                              origin.y() + data.yTranslation() + (rect.y() - origin.y()) * data.yScale(),
+                              rect.width() * data.xScale(),
+                              rect.height() * data.yScale()).toAlignedRect();
+            };
+
+            QRegion transformedShape;
+            for (const QRect &rect : shape)
+                transformedShape += transform(rect);
+            shape = transformedShape;
+            paintShape = shape;
+            windowRect = transform(windowRect);
+        } else {
+            paintShape = shape & region;
+        }
+
+        // A transformed window moves over a different background every frame.
+        if (!paintShape.isEmpty())
+            doBlur(it.value(), shape, paintShape, windowRect, Cutefish::roundedCorners(w), data.opacity(),
+                   data.screenProjectionMatrix(), !transformed);
+    }
+
+    KWin::Effect::drawWindow(w, mask, region, data);
+}
+
+void BlurEffect::doBlur(BlurWindow &info, const QRegion &shape, const QRegion &paintShape, const QRect &windowRect,
+                        Cutefish::Corners corners, qreal opacity, const QMatrix4x4 &screenProjection, bool cacheable)
+{
+    const QRect sourceRect = expand(shape).boundingRect() & KWin::effects->virtualScreenGeometry();
+
+    if (sourceRect.width() < 2 || sourceRect.height() < 2)
+        return;
+
+    if (!ensureShaders() || !ensurePyramid(info, sourceRect.size()))
+        return;
+
+    if (!cacheable || !info.cacheValid || info.cacheRect != sourceRect) {
+        // Level 0: what is behind the window, at half resolution.
+        info.renderTargets.first()->blitFromFramebuffer(sourceRect, QRect(QPoint(0, 0), info.textures.first()->size()), GL_LINEAR);
+
+        glDisable(GL_BLEND);
+
+        KWin::ShaderManager::instance()->pushShader(m_downsampleShader);
+        for (int i = 1; i <= m_iterations; ++i)
+            renderPass(m_downsampleShader, info.textures[i - 1], info.renderTargets[i], info.textures[i]->size(), m_offset);
+        KWin::ShaderManager::instance()->popShader();
+
+        KWin::ShaderManager::instance()->pushShader(m_upsampleShader);
+        for (int i = m_iterations - 1; i >= 1; --i)
+            renderPass(m_upsampleShader, info.textures[i + 1], info.renderTargets[i], info.textures[i]->size(), m_offset);
+        KWin::ShaderManager::instance()->popShader();
+
+        info.cacheValid = cacheable;
+        info.cacheRect = sourceRect;
+    }
+
+    // Final upsample from level 1 onto the screen, only inside the shape.
+    KWin::GLTexture *texture = info.textures.at(qMin(1, m_iterations));
+
+    QVector<float> vertices, texcoords;
+    for (const QRect &rect : paintShape) {
+        const QRectF tex((rect.x() - sourceRect.x()) / qreal(sourceRect.width()),
+                         1.0 - (rect.y() - sourceRect.y()) / qreal(sourceRect.height()),
+                         rect.width() / qreal(sourceRect.width()),
+                         -rect.height() / qreal(sourceRect.height()));
+        appendQuad(vertices, texcoords, rect, tex);
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    KWin::ShaderManager::instance()->pushShader(m_compositeShader);
+    m_compositeShader->setUniform(KWin::GLShader::ModelViewProjectionMatrix, screenProjection);
+    m_compositeShader->setUniform("halfpixel", QVector2D(0.5 / texture->width(), 0.5 / texture->height()));
+    m_compositeShader->setUniform("offset", m_offset);
+    m_compositeShader->setUniform("sourceSize", QVector2D(sourceRect.width(), sourceRect.height()));
+    m_compositeShader->setUniform("windowRect", QVector4D(windowRect.x() - sourceRect.x(),
+                                                          windowRect.y() - sourceRect.y(),
+                                                          windowRect.width(),
+                                                          windowRect.height()));
+    auto radius = [&](Cutefish::Corner corner) {
+        return corners.testFlag(corner) ? float(m_frameRadius) : 0.0f;
+    };
+    m_compositeShader->setUniform("radii", QVector4D(radius(Cutefish::TopLeftCorner), radius(Cutefish::TopRightCorner),
+                                                     radius(Cutefish::BottomLeftCorner), radius(Cutefish::BottomRightCorner)));
+    m_compositeShader->setUniform("opacity", float(opacity));
+
+    texture->bind();
+    renderQuads(vertices, texcoords);
+    texture->unbind();
+
+    KWin::ShaderManager::instance()->popShader();
+
+    glDisable(GL_BLEND);
+}
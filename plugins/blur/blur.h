@@ -0,0 +1,122 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef BLUR_H
+#define BLUR_H
+
+#include <kwineffects.h>
+#include <kwinglplatform.h>
+#include <kwinglutils.h>
+
+#include <QHash>
+#include <QSet>
+#include <QSettings>
+#include <QVector>
+
+#include "corners.h"
+
+namespace Cutefish
+{
+class PowerProfile;
+}
+
+class BlurEffect : public KWin::Effect
+{
+    Q_OBJECT
+
+public:
+    BlurEffect(QObject *parent = nullptr, const QVariantList &args = QVariantList());
+    ~BlurEffect();
+
+    static bool supported();
+    static bool enabledByDefault();
+
+    void reconfigure(ReconfigureFlags flags) override;
+    bool provides(Feature feature) override;
+    bool isActive() const override;
+#if KWIN_EFFECT_API_VERSION >= 233
+    bool blocksDirectScanout() const override;
+#endif
+
+    void prePaintScreen(KWin::ScreenPrePaintData &data, std::chrono::milliseconds presentTime) override;
+    void prePaintWindow(KWin::EffectWindow *w, KWin::WindowPrePaintData &data, std::chrono::milliseconds presentTime) override;
+    void postPaintScreen() override;
+    void drawWindow(KWin::EffectWindow *w, int mask, const QRegion &region, KWin::WindowPaintData &data) override;
+
+private slots:
+    void slotWindowAdded(KWin::EffectWindow *w);
+    void slotWindowDeleted(KWin::EffectWindow *w);
+    void slotPropertyNotify(KWin::EffectWindow *w, long atom);
+    void slotWindowDamaged(KWin::EffectWindow *w);
+    void slotWindowGeometryChanged(KWin::EffectWindow *w, const QRect &oldGeometry);
+    void invalidateCaches();
+
+private:
+    struct BlurWindow {
+        // Blur region relative to the client area, empty means all of it.
+        QRegion region;
+
+        // Dual-Kawase pyramid sized to the area behind the window, level i
+        // is 1 / 2^(i + 1) of it.
+        QSize size;
+        QVector<KWin::GLTexture *> textures;
+        QVector<KWin::GLRenderTarget *> renderTargets;
+
+        // Level 1 still holds the blurred background of cacheRect, nothing
+        // below the window has changed there since it was computed.
+        bool cacheValid = false;
+        QRect cacheRect;
+    };
+
+    void updateBlurRegion(KWin::EffectWindow *w);
+    QRegion blurRegion(KWin::EffectWindow *w) const;
+    QRegion expand(const QRegion &region) const;
+
+    bool ensurePyramid(BlurWindow &info, const QSize &size);
+    void releasePyramid(BlurWindow &info);
+    bool ensureShaders();
+
+    void doBlur(BlurWindow &info, const QRegion &shape, const QRegion &paintShape, const QRect &windowRect,
+                Cutefish::Corners corners, qreal opacity, const QMatrix4x4 &screenProjection, bool cacheable);
+
+    QSettings *m_settings;
+    Cutefish::PowerProfile *m_powerProfile;
+    long m_atom = 0;
+
+    QHash<KWin::EffectWindow *, BlurWindow> m_windows;
+
+    // Screen damage not yet seen by the windows above its source, and
+    // damage that can not be tied to a stacking position.
+    QHash<KWin::EffectWindow *, QRegion> m_pendingDamage;
+    QRegion m_globalDamage;
+    QRegion m_damagedArea;
+    // Windows drawn below full opacity in the last frame, by any effect.
+    QSet<KWin::EffectWindow *> m_translucentWindows;
+
+    KWin::GLShader *m_downsampleShader = nullptr;
+    KWin::GLShader *m_upsampleShader = nullptr;
+    KWin::GLShader *m_compositeShader = nullptr;
+
+    int m_iterations = 1;
+    float m_offset = 1.0f;
+    int m_expandSize = 0;
+    int m_frameRadius = 0;
+};
+
+#endif
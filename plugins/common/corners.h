@@ -0,0 +1,72 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef CORNERS_H
+#define CORNERS_H
+
+#include <QFlags>
+#include <QRect>
+
+namespace Cutefish
+{
+
+enum Corner {
+    TopLeftCorner = 1 << 0,
+    TopRightCorner = 1 << 1,
+    BottomLeftCorner = 1 << 2,
+    BottomRightCorner = 1 << 3
+};
+Q_DECLARE_FLAGS(Corners, Corner)
+Q_DECLARE_OPERATORS_FOR_FLAGS(Corners)
+
+// The rule shared by the decoration and the effects: a corner is rounded
+// unless one of its two edges is adjacent to the work area border, as
+// KWin reports it for maximized and quick tiled windows.
+inline Corners cornersClearOf(Qt::Edges edges)
+{
+    Corners corners;
+    if (!(edges & (Qt::LeftEdge | Qt::TopEdge)))
+        corners |= TopLeftCorner;
+    if (!(edges & (Qt::RightEdge | Qt::TopEdge)))
+        corners |= TopRightCorner;
+    if (!(edges & (Qt::LeftEdge | Qt::BottomEdge)))
+        corners |= BottomLeftCorner;
+    if (!(edges & (Qt::RightEdge | Qt::BottomEdge)))
+        corners |= BottomRightCorner;
+    return corners;
+}
+
+// Edges of geometry lying on, or past, the border of area.
+inline Qt::Edges screenEdges(const QRect &geometry, const QRect &area)
+{
+    Qt::Edges edges;
+    if (geometry.left() <= area.left())
+        edges |= Qt::LeftEdge;
+    if (geometry.top() <= area.top())
+        edges |= Qt::TopEdge;
+    if (geometry.right() >= area.right())
+        edges |= Qt::RightEdge;
+    if (geometry.bottom() >= area.bottom())
+        edges |= Qt::BottomEdge;
+    return edges;
+}
+
+}
+
+#endif
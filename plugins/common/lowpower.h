@@ -0,0 +1,78 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef LOWPOWER_H
+#define LOWPOWER_H
+
+#include <kwineffects.h>
+
+#include <QCoreApplication>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "lowpowerfile.h"
+
+// Hands the power profile on to the scripted effects, which read LowPower
+// from their own kwinrc group, see LowPowerFile for how it gets there.
+// Every effect module that follows the power profile calls this, an
+// unchanged value is skipped, so it does not matter which of them is
+// loaded. Call it again from reconfigure().
+
+namespace Cutefish
+{
+
+inline void handOffLowPower(bool lowPower)
+{
+    static const QStringList scriptedEffects = {
+        QStringLiteral("cutefish_scale"),
+        QStringLiteral("cutefish_popups"),
+        QStringLiteral("cutefish_squash"),
+    };
+
+    // Earlier builds wrote the entry to disk, where it would override the
+    // runtime file. effectConfig() reads the file on disk.
+    static bool cleaned = false;
+    if (!cleaned) {
+        for (const QString &effect : scriptedEffects) {
+            KConfigGroup config = KWin::effects->effectConfig(effect);
+            if (config.hasKey("LowPower")) {
+                config.deleteEntry("LowPower");
+                config.sync();
+            }
+        }
+        cleaned = true;
+    }
+
+    // The instance ScriptedEffect builds its KConfigLoader on, not the
+    // NoGlobals one behind effectConfig().
+    KSharedConfig::Ptr config = QCoreApplication::instance()->property("config").value<KSharedConfig::Ptr>();
+    if (!config)
+        config = KSharedConfig::openConfig(QStringLiteral("kwinrc"));
+
+    const QStringList changed = LowPowerFile::publish(config, lowPower, scriptedEffects);
+    for (const QString &effect : changed) {
+        if (KWin::effects->isEffectLoaded(effect))
+            KWin::effects->reconfigureEffect(effect);
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "lowpowerfile.h"
+
+#include <QStandardPaths>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+namespace Cutefish
+{
+
+namespace LowPowerFile
+{
+
+QString path()
+{
+    const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    return runtimeDir.isEmpty() ? QString() : runtimeDir + QStringLiteral("/cutefish-lowpowerrc");
+}
+
+static QString groupName(const QString &effect)
+{
+    return QStringLiteral("Effect-") + effect;
+}
+
+QStringList publish(const KSharedConfig::Ptr &config, bool lowPower, const QStringList &effects)
+{
+    const QString file = path();
+    if (file.isEmpty() || !config)
+        return {};
+
+    // What the effects have read so far, before the file comes in.
+    QStringList changed;
+    for (const QString &effect : effects) {
+        if (config->group(groupName(effect)).readEntry("LowPower", false) != lowPower)
+            changed << effect;
+    }
+
+    KConfig state(file, KConfig::SimpleConfig);
+    for (const QString &effect : effects)
+        state.group(groupName(effect)).writeEntry("LowPower", lowPower);
+    state.sync();
+
+    // Adding a source reparses config, once per process and config.
+    if (!config->additionalConfigSources().contains(file))
+        config->addConfigSources({ file });
+
+    for (const QString &effect : qAsConst(changed)) {
+        KConfigGroup group = config->group(groupName(effect));
+
+        // Until the next reparse brings in the file. Never written to
+        // config's own file.
+        if (group.readEntry("LowPower", false) != lowPower)
+            group.writeEntry("LowPower", lowPower, KConfigBase::WriteConfigFlags());
+    }
+
+    return changed;
+}
+
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef LOWPOWERFILE_H
+#define LOWPOWERFILE_H
+
+#include <QString>
+#include <QStringList>
+
+#include <KSharedConfig>
+
+// The power profile as the scripted effects see it. Their KConfigLoader
+// reads KWin's main kwinrc instance, so the state is kept in a small file
+// in the runtime directory, stacked under that instance as an extra
+// config source:
+//
+//   $XDG_RUNTIME_DIR/cutefish-lowpowerrc
+//   [Effect-cutefish_scale]
+//   LowPower=true
+//
+// KWin re-reads the file whenever it reparses kwinrc, the file is gone
+// with the session, and the user's kwinrc never gets the entry.
+
+namespace Cutefish
+{
+
+namespace LowPowerFile
+{
+
+QString path();
+
+// Writes the state for each effect and makes config see it right away,
+// before its next reparse. Returns the effects whose value changed.
+QStringList publish(const KSharedConfig::Ptr &config, bool lowPower, const QStringList &effects);
+
+}
+
+}
+
+#endif
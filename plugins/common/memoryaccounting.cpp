@@ -0,0 +1,220 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "memoryaccounting.h"
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QMap>
+#include <QMetaObject>
+#include <QObject>
+#include <QThread>
+#include <QTextStream>
+#include <QVariant>
+#include <QVariantMap>
+
+#include <mutex>
+
+namespace Cutefish
+{
+
+namespace Memory
+{
+
+// Bump when Usage or Registry change layout, see Trace for why it is
+// shared through a property.
+static const char s_registryProperty[] = "_cutefish_memory_registry_v1";
+static const char s_objectPath[] = "/Cutefish/Memory";
+
+struct Usage {
+    qint64 bytes[2] = { 0, 0 };
+    int count[2] = { 0, 0 };
+};
+
+struct Registry {
+    std::mutex mutex;
+    QMap<QString, Usage> usage;
+    // Whether some module has the D-Bus object registered, guarded by
+    // mutex like the rest.
+    bool exported = false;
+};
+
+static Registry *registry()
+{
+    static Registry *s_registry = [] {
+        QCoreApplication *app = QCoreApplication::instance();
+        if (!app)
+            return new Registry;
+
+        Registry *shared = static_cast<Registry *>(app->property(s_registryProperty).value<void *>());
+        if (!shared) {
+            shared = new Registry;
+            app->setProperty(s_registryProperty, QVariant::fromValue<void *>(shared));
+        }
+        return shared;
+    }();
+
+    return s_registry;
+}
+
+class Reporter : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.cutefish.Memory")
+
+public:
+    Q_SCRIPTABLE QString report() const
+    {
+        return Memory::report();
+    }
+
+    Q_SCRIPTABLE QVariantMap cpuBytes() const
+    {
+        return bytes(Cpu);
+    }
+
+    Q_SCRIPTABLE QVariantMap gpuBytes() const
+    {
+        return bytes(Gpu);
+    }
+
+private:
+    static QVariantMap bytes(Domain domain)
+    {
+        Registry *r = registry();
+        std::lock_guard<std::mutex> lock(r->mutex);
+
+        QVariantMap map;
+        for (auto it = r->usage.constBegin(); it != r->usage.constEnd(); ++it)
+            map.insert(it.key(), it.value().bytes[domain]);
+        return map;
+    }
+};
+
+// The object registered by this module. Its code goes away with the
+// module, so it is unregistered then and another module takes over.
+static Reporter *s_reporter = nullptr;
+
+static struct ReporterGuard {
+    ~ReporterGuard()
+    {
+        if (!s_reporter)
+            return;
+
+        if (QCoreApplication::instance()) {
+            Registry *r = registry();
+            std::lock_guard<std::mutex> lock(r->mutex);
+            QDBusConnection::sessionBus().unregisterObject(QString::fromLatin1(s_objectPath));
+            r->exported = false;
+        }
+
+        delete s_reporter;
+        s_reporter = nullptr;
+    }
+} s_reporterGuard;
+
+static void account(const char *category, Domain domain, qint64 bytes, int count)
+{
+    Registry *r = registry();
+
+    {
+        std::lock_guard<std::mutex> lock(r->mutex);
+        Usage &usage = r->usage[QString::fromLatin1(category)];
+        usage.bytes[domain] += bytes;
+        usage.count[domain] += count;
+    }
+}
+
+void allocated(const char *category, Domain domain, qint64 bytes)
+{
+    account(category, domain, bytes, 1);
+}
+
+void freed(const char *category, Domain domain, qint64 bytes)
+{
+    account(category, domain, -bytes, -1);
+}
+
+qint64 bytes(const char *category, Domain domain)
+{
+    Registry *r = registry();
+    std::lock_guard<std::mutex> lock(r->mutex);
+    return r->usage.value(QString::fromLatin1(category)).bytes[domain];
+}
+
+int count(const char *category, Domain domain)
+{
+    Registry *r = registry();
+    std::lock_guard<std::mutex> lock(r->mutex);
+    return r->usage.value(QString::fromLatin1(category)).count[domain];
+}
+
+QString report()
+{
+    Registry *r = registry();
+    std::lock_guard<std::mutex> lock(r->mutex);
+
+    qint64 total[2] = { 0, 0 };
+
+    QString info;
+    QTextStream stream(&info);
+    for (auto it = r->usage.constBegin(); it != r->usage.constEnd(); ++it) {
+        const Usage &usage = it.value();
+        stream << it.key() << ": "
+               << "cpu " << usage.bytes[Cpu] << " bytes in " << usage.count[Cpu] << ", "
+               << "gpu " << usage.bytes[Gpu] << " bytes in " << usage.count[Gpu] << "\n";
+        total[Cpu] += usage.bytes[Cpu];
+        total[Gpu] += usage.bytes[Gpu];
+    }
+    stream << "total: cpu " << total[Cpu] << " bytes, gpu " << total[Gpu] << " bytes\n";
+
+    return info;
+}
+
+void exportReport()
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    if (!app)
+        return;
+
+    // The Reporter has to live on the thread that dispatches D-Bus calls.
+    if (QThread::currentThread() != app->thread()) {
+        QMetaObject::invokeMethod(app, &exportReport, Qt::QueuedConnection);
+        return;
+    }
+
+    Registry *r = registry();
+    std::lock_guard<std::mutex> lock(r->mutex);
+    if (r->exported)
+        return;
+
+    s_reporter = new Reporter;
+    r->exported = QDBusConnection::sessionBus().registerObject(QString::fromLatin1(s_objectPath), s_reporter,
+                                                               QDBusConnection::ExportScriptableSlots);
+    if (!r->exported) {
+        delete s_reporter;
+        s_reporter = nullptr;
+    }
+}
+
+}
+
+}
+
+#include "memoryaccounting.moc"
@@ -0,0 +1,60 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include <QString>
+
+// Bytes held by the plugins, by category, across every module loaded in
+// the process. Readable with
+//
+//   qdbus org.kde.KWin /Cutefish/Memory report
+//   qdbus org.kde.KWin /Effects debug kwin4_effect_roundedwindow memory
+
+namespace Cutefish
+{
+
+namespace Memory
+{
+
+enum Domain {
+    Cpu,
+    Gpu
+};
+
+void allocated(const char *category, Domain domain, qint64 bytes);
+void freed(const char *category, Domain domain, qint64 bytes);
+
+// What is held in a category now, for tests.
+qint64 bytes(const char *category, Domain domain);
+int count(const char *category, Domain domain);
+
+QString report();
+
+// Registers /Cutefish/Memory on the session bus unless a module already
+// has. Call it when an effect or decoration is created, calls from other
+// threads are queued to the GUI thread.
+void exportReport();
+
+}
+
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "powerprofile.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
+#include <QDBusVariant>
+
+namespace Cutefish
+{
+
+static const QString s_propertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+
+static const QString s_profilesService = QStringLiteral("net.hadess.PowerProfiles");
+static const QString s_profilesPath = QStringLiteral("/net/hadess/PowerProfiles");
+
+static const QString s_upowerService = QStringLiteral("org.freedesktop.UPower");
+static const QString s_upowerPath = QStringLiteral("/org/freedesktop/UPower");
+
+PowerProfile::PowerProfile(QObject *parent)
+    : PowerProfile(QDBusConnection::systemBus(), parent)
+{
+}
+
+PowerProfile::PowerProfile(const QDBusConnection &bus, QObject *parent)
+    : QObject(parent)
+    , m_bus(bus)
+{
+    m_bus.connect(s_profilesService, s_profilesPath, s_propertiesInterface, QStringLiteral("PropertiesChanged"),
+                this, SLOT(slotPropertiesChanged(QString, QVariantMap, QStringList)));
+    m_bus.connect(s_upowerService, s_upowerPath, s_propertiesInterface, QStringLiteral("PropertiesChanged"),
+                this, SLOT(slotPropertiesChanged(QString, QVariantMap, QStringList)));
+
+    // Both daemons are D-Bus activated and may start after KWin.
+    QDBusServiceWatcher *watcher = new QDBusServiceWatcher(this);
+    watcher->setConnection(m_bus);
+    watcher->addWatchedService(s_profilesService);
+    watcher->addWatchedService(s_upowerService);
+    connect(watcher, &QDBusServiceWatcher::serviceRegistered, this, [this](const QString &service) {
+        if (service == s_profilesService)
+            fetch(s_profilesService, s_profilesPath, s_profilesService, QStringLiteral("ActiveProfile"));
+        else
+            fetch(s_upowerService, s_upowerPath, s_upowerService, QStringLiteral("OnBattery"));
+    });
+    connect(watcher, &QDBusServiceWatcher::serviceUnregistered, this, [this](const QString &service) {
+        if (service == s_profilesService)
+            update(QStringLiteral("ActiveProfile"), QString());
+        else
+            update(QStringLiteral("OnBattery"), false);
+    });
+
+    fetch(s_profilesService, s_profilesPath, s_profilesService, QStringLiteral("ActiveProfile"));
+    fetch(s_upowerService, s_upowerPath, s_upowerService, QStringLiteral("OnBattery"));
+}
+
+QString PowerProfile::profile() const
+{
+    return m_profile;
+}
+
+bool PowerProfile::onBattery() const
+{
+    return m_onBattery;
+}
+
+bool PowerProfile::isLowPower() const
+{
+    // An explicit profile wins, the battery only counts without the daemon.
+    if (!m_profile.isEmpty())
+        return m_profile == QLatin1String("power-saver");
+
+    return m_onBattery;
+}
+
+void PowerProfile::fetch(const QString &service, const QString &path, const QString &interface, const QString &property)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(service, path, s_propertiesInterface, QStringLiteral("Get"));
+    message << interface << property;
+
+    // Never block the compositor on the system bus.
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, property](QDBusPendingCallWatcher *watcher) {
+        QDBusPendingReply<QDBusVariant> reply = *watcher;
+        if (!reply.isError())
+            update(property, reply.value().variant());
+        watcher->deleteLater();
+    });
+}
+
+void PowerProfile::slotPropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated)
+{
+    Q_UNUSED(invalidated)
+
+    if (interface != s_profilesService && interface != s_upowerService)
+        return;
+
+    for (auto it = changed.constBegin(); it != changed.constEnd(); ++it)
+        update(it.key(), it.value());
+}
+
+void PowerProfile::update(const QString &property, const QVariant &value)
+{
+    const bool wasLowPower = isLowPower();
+
+    if (property == QLatin1String("ActiveProfile"))
+        m_profile = value.toString();
+    else if (property == QLatin1String("OnBattery"))
+        m_onBattery = value.toBool();
+    else
+        return;
+
+    if (isLowPower() != wasLowPower)
+        emit changed();
+}
+
+}
@@ -0,0 +1,69 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef POWERPROFILE_H
+#define POWERPROFILE_H
+
+#include <QDBusConnection>
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+
+// Follows power-profiles-daemon and UPower on the system bus. The plugins
+// drop to their cheapest paths while isLowPower() is set.
+//
+//   qdbus --system net.hadess.PowerProfiles /net/hadess/PowerProfiles \
+//         org.freedesktop.DBus.Properties.Set net.hadess.PowerProfiles ActiveProfile power-saver
+
+namespace Cutefish
+{
+
+class PowerProfile : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PowerProfile(QObject *parent = nullptr);
+    // Watches the daemons on another bus, for tests.
+    explicit PowerProfile(const QDBusConnection &bus, QObject *parent = nullptr);
+
+    // "performance", "balanced" or "power-saver", empty without the daemon.
+    QString profile() const;
+    bool onBattery() const;
+
+    bool isLowPower() const;
+
+signals:
+    void changed();
+
+private slots:
+    void slotPropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+
+private:
+    void fetch(const QString &service, const QString &path, const QString &interface, const QString &property);
+    void update(const QString &property, const QVariant &value);
+
+    QDBusConnection m_bus;
+    QString m_profile;
+    bool m_onBattery = false;
+};
+
+}
+
+#endif
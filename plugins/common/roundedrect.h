@@ -0,0 +1,60 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef ROUNDEDRECT_H
+#define ROUNDEDRECT_H
+
+namespace Cutefish
+{
+
+// Window corner radius at a theme PixelRatio of 1.
+static const int FrameRadius = 11;
+
+// GLSL ES fragment shaders have no default float precision. Colors and
+// corner local distances fit in mediump, window coordinates are declared
+// HIGHP, which is highp where the fragment stage has it. Desktop GL
+// shaders define HIGHP empty.
+static const char GlesPrecision[] =
+    "precision mediump float;\n"
+    "\n"
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "#define HIGHP highp\n"
+    "#else\n"
+    "#define HIGHP mediump\n"
+    "#endif\n"
+    "\n";
+
+static const char DesktopPrecision[] =
+    "#define HIGHP\n"
+    "\n";
+
+// GLSL: signed distance from p to the rounded rectangle rect (x, y, width,
+// height) with corner radius r. Negative inside, in the units of p. Needs
+// one of the precision preambles above.
+static const char RoundedRectSdf[] =
+    "float roundedRectSdf(HIGHP vec2 p, HIGHP vec4 rect, float r)\n"
+    "{\n"
+    "    HIGHP vec2 halfSize = rect.zw * 0.5;\n"
+    "    vec2 q = abs(p - rect.xy - halfSize) - halfSize + vec2(r);\n"
+    "    return min(max(q.x, q.y), 0.0) + length(max(q, 0.0)) - r;\n"
+    "}\n";
+
+}
+
+#endif
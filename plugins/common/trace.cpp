@@ -0,0 +1,183 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QVariant>
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace Cutefish
+{
+
+namespace Trace
+{
+
+// Bump when Event, ThreadBuffer or Registry change layout, modules built
+// from different versions then keep separate registries.
+static const char s_registryProperty[] = "_cutefish_trace_registry_v1";
+
+static const int s_bufferSize = 4096;
+
+struct Event {
+    // Copied, the module owning a literal may be unloaded before the dump.
+    char name[48];
+    qint64 start;
+    qint64 duration;
+};
+
+struct ThreadBuffer {
+    long tid = 0;
+    // Written only by the owning thread, read by the dump.
+    std::atomic<quint64> head { 0 };
+    Event events[s_bufferSize];
+};
+
+struct Registry {
+    std::mutex mutex;
+    QVector<ThreadBuffer *> buffers;
+};
+
+// Every module links its own copy of this library and KWin loads them
+// with local symbols. They find each other's registry through a property
+// on the application object, so a dump covers the whole process.
+static Registry *registry()
+{
+    static Registry *s_registry = [] {
+        QCoreApplication *app = QCoreApplication::instance();
+        if (!app)
+            return new Registry;
+
+        Registry *shared = static_cast<Registry *>(app->property(s_registryProperty).value<void *>());
+        if (!shared) {
+            shared = new Registry;
+            app->setProperty(s_registryProperty, QVariant::fromValue<void *>(shared));
+        }
+        return shared;
+    }();
+
+    return s_registry;
+}
+
+static ThreadBuffer *threadBuffer()
+{
+    // Never freed, events of finished threads stay readable.
+    thread_local ThreadBuffer *buffer = [] {
+        ThreadBuffer *b = new ThreadBuffer;
+        b->tid = syscall(SYS_gettid);
+
+        Registry *r = registry();
+        std::lock_guard<std::mutex> lock(r->mutex);
+        r->buffers.append(b);
+        return b;
+    }();
+
+    return buffer;
+}
+
+bool enabled()
+{
+    static const bool s_enabled = [] {
+        const QByteArray value = qgetenv("CUTEFISH_TRACE");
+        return !value.isEmpty() && value != "0";
+    }();
+
+    return s_enabled;
+}
+
+qint64 now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void record(const char *name, qint64 start, qint64 duration)
+{
+    ThreadBuffer *buffer = threadBuffer();
+
+    const quint64 head = buffer->head.load(std::memory_order_relaxed);
+    Event &event = buffer->events[head % s_bufferSize];
+
+    qstrncpy(event.name, name, sizeof(event.name));
+    event.start = start;
+    event.duration = duration;
+
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+QByteArray dumpChromeJson()
+{
+    struct Entry {
+        Event event;
+        long tid;
+    };
+
+    QVector<Entry> entries;
+
+    {
+        Registry *r = registry();
+        std::lock_guard<std::mutex> lock(r->mutex);
+
+        for (ThreadBuffer *buffer : qAsConst(r->buffers)) {
+            const quint64 head = buffer->head.load(std::memory_order_acquire);
+            const quint64 count = qMin<quint64>(head, s_bufferSize);
+
+            // Best effort: the owning thread may overwrite the oldest
+            // events while they are copied.
+            for (quint64 i = head - count; i < head; ++i)
+                entries.append({ buffer->events[i % s_bufferSize], buffer->tid });
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.event.start < b.event.start;
+    });
+
+    const QByteArray pid = QByteArray::number(qint64(getpid()));
+
+    QByteArray json = "{\"traceEvents\":[";
+    for (int i = 0; i < entries.size(); ++i) {
+        const Entry &entry = entries.at(i);
+
+        if (i > 0)
+            json += ',';
+
+        json += "{\"name\":\"" + QByteArray(entry.event.name) + "\""
+                ",\"cat\":\"cutefish\",\"ph\":\"X\""
+                ",\"ts\":" + QByteArray::number(entry.event.start) +
+                ",\"dur\":" + QByteArray::number(entry.event.duration) +
+                ",\"pid\":" + pid +
+                ",\"tid\":" + QByteArray::number(qint64(entry.tid)) + "}";
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}";
+
+    return json;
+}
+
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+
+#include <cstdint>
+
+// Timeline markers for the paint paths. Built in with -DCUTEFISH_TRACING=ON
+// and recorded only when CUTEFISH_TRACE=1 is set in KWin's environment.
+//
+//   CUTEFISH_TRACE_SCOPE("RoundedWindow::drawWindow");
+//
+// Events go to a ring buffer per thread and are dumped as Chrome trace
+// JSON, loadable in chrome://tracing and ui.perfetto.dev, with
+//
+//   qdbus org.kde.KWin /Effects debug kwin4_effect_roundedwindow trace
+
+namespace Cutefish
+{
+
+namespace Trace
+{
+
+bool enabled();
+
+// Monotonic clock in microseconds, the clock KWin stamps its frames with.
+qint64 now();
+
+void record(const char *name, qint64 start, qint64 duration);
+
+// Events of every module and thread in the process, oldest first.
+QByteArray dumpChromeJson();
+
+}
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : m_name(name)
+        , m_start(Trace::enabled() ? Trace::now() : -1)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_start >= 0)
+            Trace::record(m_name, m_start, Trace::now() - m_start);
+    }
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char *m_name;
+    qint64 m_start;
+};
+
+}
+
+#ifdef CUTEFISH_TRACING
+#define CUTEFISH_TRACE_CONCAT_(a, b) a##b
+#define CUTEFISH_TRACE_CONCAT(a, b) CUTEFISH_TRACE_CONCAT_(a, b)
+#define CUTEFISH_TRACE_SCOPE(name) \
+    Cutefish::TraceScope CUTEFISH_TRACE_CONCAT(cutefishTraceScope, __LINE__)(name)
+#else
+#define CUTEFISH_TRACE_SCOPE(name) do { } while (0)
+#endif
+
+#endif
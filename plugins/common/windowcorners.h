@@ -0,0 +1,145 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef WINDOWCORNERS_H
+#define WINDOWCORNERS_H
+
+#include "corners.h"
+
+#include <kwineffects.h>
+
+#include <QStringList>
+
+// Which corners of a window the effects round, shared by roundedwindow and
+// the blur behind it so both clip to the same shape.
+
+namespace Cutefish
+{
+
+// Windows rounded even though their type would keep them square, mostly
+// applications drawing their own frame.
+inline const QStringList &roundedAllowList()
+{
+    static const QStringList allowList = { "netease-cloud-music netease-cloud-music",
+                                           "com.alibabainc.dingtalk com.alibabainc.dingtalk",
+                                           "tenvideo_universal tenvideo_universal",
+                                           "com.eusoft.ting.en com.eusoft.ting.en",
+                                           "i4toolslinux i4tools",
+                                           "youku-app youku-app",
+                                           "qqmusic qqmusic",
+                                           "mytime mytime",
+                                           "feishu feishu",
+                                           "bytedance-feishu bytedance-feishu",
+                                           "xmind xmind",
+                                           "mtxx mtxx",
+                                           "ynote-desktop ynote-desktop",
+
+                                           // Open source software
+                                           "code code",
+                                           "motrix motrix"
+                                         };
+    return allowList;
+}
+
+// Maximize state of a window as horizontal | vertical << 1, recorded by
+// trackMaximizeState(). Far above the roles KWin and its effects use.
+static const int WindowMaximizedRole = KWin::DataRole::LanczosCacheRole + 200;
+
+// The effects only learn the maximize state from this signal. Every module
+// using adjacentEdges() connects it, the recorded value is the same.
+inline void trackMaximizeState(QObject *context)
+{
+    QObject::connect(KWin::effects, &KWin::EffectsHandler::windowMaximizedStateChanged, context,
+                     [](KWin::EffectWindow *w, bool horizontal, bool vertical) {
+        w->setData(WindowMaximizedRole, int(horizontal) | int(vertical) << 1);
+    });
+}
+
+// What KWin reports to the decoration as DecoratedClient::adjacentScreenEdges,
+// from maximize and quick tile state, so the decoration and the effects
+// square the same corners. A window merely moved against a border is not
+// adjacent, just as for the decoration.
+inline Qt::Edges adjacentEdges(KWin::EffectWindow *w)
+{
+    const QRect geo = w->frameGeometry();
+    const QRect area = KWin::effects->clientArea(KWin::MaximizeArea, w);
+    const bool fullWidth = geo.left() <= area.left() && geo.right() >= area.right();
+    const bool fullHeight = geo.top() <= area.top() && geo.bottom() >= area.bottom();
+
+    bool horizontal = fullWidth;
+    bool vertical = fullHeight;
+    // Windows maximized before the effect was loaded only show in their
+    // geometry.
+    const QVariant maximized = w->data(WindowMaximizedRole);
+    if (maximized.isValid()) {
+        horizontal = maximized.toInt() & 1;
+        vertical = maximized.toInt() & 2;
+    }
+
+    Qt::Edges edges;
+    if (horizontal)
+        edges |= Qt::LeftEdge | Qt::RightEdge;
+    if (vertical)
+        edges |= Qt::TopEdge | Qt::BottomEdge;
+
+    // Quick tiles are a half or a quarter of the work area, against its
+    // border. A side tile counts as touching both ends of that side.
+    const bool halfWidth = qAbs(geo.width() - area.width() / 2) <= 1;
+    const bool halfHeight = qAbs(geo.height() - area.height() / 2) <= 1;
+    const Qt::Edges flush = screenEdges(geo, area);
+
+    Qt::Edges tile;
+    if (halfWidth && (fullHeight || halfHeight))
+        tile |= flush & (Qt::LeftEdge | Qt::RightEdge);
+    if (halfHeight && (fullWidth || halfWidth))
+        tile |= flush & (Qt::TopEdge | Qt::BottomEdge);
+
+    if (tile) {
+        edges |= tile;
+        if (!(tile & (Qt::TopEdge | Qt::BottomEdge)))
+            edges |= Qt::TopEdge | Qt::BottomEdge;
+        if (!(tile & (Qt::LeftEdge | Qt::RightEdge)))
+            edges |= Qt::LeftEdge | Qt::RightEdge;
+    }
+
+    return edges;
+}
+
+inline Corners roundedCorners(KWin::EffectWindow *w)
+{
+    // Decided again every frame: a window going full screen is back on the
+    // opaque path, and eligible for direct scanout, with its next paint.
+    if (w->isFullScreen())
+        return Corners();
+
+    if (w->isDesktop()
+            || w->isMenu()
+            || w->isDock()
+            || w->isPopupWindow()
+            || w->isPopupMenu()) {
+        if (!roundedAllowList().contains(w->windowClass()))
+            return Corners();
+    }
+
+    return cornersClearOf(adjacentEdges(w));
+}
+
+}
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "button.h"
 #include "decoration.h"
+#include "trace.h"
 
 #include <KDecoration2/DecoratedClient>
 #include <KDecoration2/Decoration>
@@ -59,6 +60,8 @@ KDecoration2::DecorationButton *Button::create(KDecoration2::DecorationButtonTyp
 
 void Button::paint(QPainter *painter, const QRect &repaintRegion)
 {
+    CUTEFISH_TRACE_SCOPE("Button::paint");
+
     Q_UNUSED(repaintRegion)
 
     Cutefish::Decoration *decoration = qobject_cast<Cutefish::Decoration *>(this->decoration());
@@ -69,6 +72,8 @@ void Button::paint(QPainter *painter, const QRect &repaintRegion)
     auto c = decoration->client().toStrongRef().data();
     const bool isDarkMode = decoration->darkMode();
     const QRect &rect = geometry().toRect();
+    // Scale of the output this decoration is being rendered for.
+    const qreal scale = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
 
     painter->save();
     painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
@@ -98,18 +103,18 @@ void Button::paint(QPainter *painter, const QRect &repaintRegion)
         break;
     }
     case KDecoration2::DecorationButtonType::Minimize: {
-        painter->drawPixmap(imgRect, decoration->minimizeBtnPixmap());
+        painter->drawPixmap(imgRect, decoration->minimizeBtnPixmap(scale));
         break;
     }
     case KDecoration2::DecorationButtonType::Maximize: {
         if (isChecked())
-            painter->drawPixmap(imgRect, decoration->restoreBtnPixmap());
+            painter->drawPixmap(imgRect, decoration->restoreBtnPixmap(scale));
         else
-            painter->drawPixmap(imgRect, decoration->maximizeBtnPixmap());
+            painter->drawPixmap(imgRect, decoration->maximizeBtnPixmap(scale));
         break;
     }
     case KDecoration2::DecorationButtonType::Close: {
-        painter->drawPixmap(imgRect, decoration->closeBtnPixmap());
+        painter->drawPixmap(imgRect, decoration->closeBtnPixmap(scale));
         break;
     }
     default:
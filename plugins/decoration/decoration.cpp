@@ -20,6 +20,10 @@
 // own
 #include "decoration.h"
 #include "button.h"
+#include "corners.h"
+#include "memoryaccounting.h"
+#include "roundedrect.h"
+#include "trace.h"
 
 // KDecoration
 #include <KDecoration2/DecoratedClient>
@@ -28,12 +32,17 @@
 
 // Qt
 #include <QApplication>
+#include <QFileSystemWatcher>
 #include <QPainter>
+#include <QScreen>
 #include <QSettings>
 #include <QSharedPointer>
 #include <QImageReader>
+#include <QPointer>
 #include <QTimer>
 
+#include <KConfig>
+#include <KConfigGroup>
 #include <KPluginFactory>
 
 #include <cmath>
@@ -50,26 +59,68 @@ static int g_shadowSize = 0;
 static int g_shadowStrength = 0;
 static QColor g_shadowColor = Qt::black;
 static QSharedPointer<KDecoration2::DecorationShadow> g_sShadow;
+static qint64 g_shadowBytes = 0;
+
+// The theme file and its watcher are shared by every decoration, each
+// watcher would otherwise hold its own inotify instance for the session.
+static QSettings *g_settings = nullptr;
+static QFileSystemWatcher *g_fileWatcher = nullptr;
+
+// The roundedwindow effect draws the shadow on the GPU when this is set.
+// Read once for every decoration, and again when KWin reconfigures them.
+static bool g_analyticShadow = false;
+static QPointer<KDecoration2::DecorationSettings> g_analyticShadowSettings;
+
+static void readAnalyticShadow()
+{
+    // A private KConfig, reparsing KWin's shared kwinrc would drop the
+    // entries the effects keep in memory only.
+    const KConfig config(QStringLiteral("kwinrc"), KConfig::NoGlobals);
+    g_analyticShadow = config.group("Effect-roundedwindow").readEntry("AnalyticShadow", false);
+}
 
 Decoration::Decoration(QObject *parent, const QVariantList &args)
     : KDecoration2::Decoration(parent, args)
-    , m_settings(new QSettings(QSettings::UserScope, "cutefishos", "theme"))
-    , m_settingsFile(m_settings->fileName())
-    , m_fileWatcher(new QFileSystemWatcher)
-    , m_x11Shadow(new X11Shadow)
 {
-    ++g_sDecoCount;
+    if (g_sDecoCount++ == 0) {
+        g_settings = new QSettings(QSettings::UserScope, "cutefishos", "theme");
+        g_fileWatcher = new QFileSystemWatcher;
+        g_fileWatcher->addPath(g_settings->fileName());
+
+        // Connected first, so the decorations read the synced values.
+        QObject::connect(g_fileWatcher, &QFileSystemWatcher::fileChanged, g_fileWatcher, [] {
+            g_settings->sync();
+
+            // Editors replace the file instead of writing to it.
+            if (!g_fileWatcher->files().contains(g_settings->fileName()))
+                g_fileWatcher->addPath(g_settings->fileName());
+        });
+
+        Cutefish::Memory::exportReport();
+    }
 }
 
 Decoration::~Decoration()
 {
     if (--g_sDecoCount == 0) {
+        delete g_fileWatcher;
+        g_fileWatcher = nullptr;
+        delete g_settings;
+        g_settings = nullptr;
+
         g_sShadow.clear();
+        Cutefish::Memory::freed("decoration/shadow", Cutefish::Memory::Cpu, g_shadowBytes);
+        g_shadowBytes = 0;
     }
+
+    for (const BtnPixmaps &pixmaps : qAsConst(m_btnPixmaps))
+        Cutefish::Memory::freed("decoration/button-pixmaps", Cutefish::Memory::Cpu, pixmaps.bytes());
 }
 
 void Decoration::paint(QPainter *painter, const QRect &repaintRegion)
 {
+    CUTEFISH_TRACE_SCOPE("Decoration::paint");
+
     auto *decoratedClient = client().toStrongRef().data();
     auto s = settings();
 
@@ -85,7 +136,7 @@ void Decoration::paint(QPainter *painter, const QRect &repaintRegion)
         painter->setBrush(titleBarBackgroundColor());
 
         if (s->isAlphaChannelSupported() && radiusAvailable()) {
-            painter->drawRoundedRect(rect(), m_frameRadius, m_frameRadius);
+            painter->drawPath(frameBackgroundPath());
         } else {
             painter->drawRect(rect());
         }
@@ -105,8 +156,17 @@ void Decoration::init()
     auto c = client().toStrongRef().data();
     auto s = settings();
 
-    m_devicePixelRatio = m_settings->value("PixelRatio", 1.0).toReal();
-    m_frameRadius = 11 * m_devicePixelRatio;
+    m_devicePixelRatio = g_settings->value("PixelRatio", 1.0).toReal();
+    m_darkMode = g_settings->value("DarkMode", false).toBool();
+    m_frameRadius = Cutefish::FrameRadius * m_devicePixelRatio;
+
+    // Connected before any decoration's reconfigure, so they all see the
+    // refreshed value.
+    if (g_analyticShadowSettings != s.data()) {
+        g_analyticShadowSettings = s.data();
+        connect(s.data(), &KDecoration2::DecorationSettings::reconfigured, s.data(), &readAnalyticShadow);
+        readAnalyticShadow();
+    }
 
     reconfigure();
     updateTitleBar();
@@ -149,23 +209,23 @@ void Decoration::init()
     connect(c, &KDecoration2::DecoratedClient::shadedChanged, this, &Decoration::updateButtonsGeometry);
 
     // cutefishos settings
-    m_fileWatcher->addPath(m_settingsFile);
-    connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, [=] {
-        m_settings->sync();
-        m_devicePixelRatio = m_settings->value("PixelRatio", 1.0).toReal();
+    connect(g_fileWatcher, &QFileSystemWatcher::fileChanged, this, [=] {
+        CUTEFISH_TRACE_SCOPE("Decoration::themeReload");
+
+        m_devicePixelRatio = g_settings->value("PixelRatio", 1.0).toReal();
+        m_darkMode = g_settings->value("DarkMode", false).toBool();
+        // The roundedwindow effect follows PixelRatio live too.
+        m_frameRadius = Cutefish::FrameRadius * m_devicePixelRatio;
 
         updateBtnPixmap();
-        update(titleBar());
+        update();
         updateTitleBar();
         updateButtonsGeometry();
         reconfigure();
-
-        bool fileDeleted = !m_fileWatcher->files().contains(m_settingsFile);
-        if (fileDeleted)
-            m_fileWatcher->addPath(m_settingsFile);
     });
 
-    updateBtnPixmap();
+    connect(qGuiApp, &QGuiApplication::screenRemoved, this, &Decoration::releaseUnusedBtnPixmaps);
+
     createButtons();
 
     // // For some reason, the shadow should be installed the last. Otherwise,
@@ -252,6 +312,13 @@ void Decoration::updateButtonsGeometry()
 
 void Decoration::updateShadow()
 {
+    CUTEFISH_TRACE_SCOPE("Decoration::updateShadow");
+
+    if (g_analyticShadow) {
+        setShadow(QSharedPointer<KDecoration2::DecorationShadow>());
+        return;
+    }
+
     // assign global shadow if exists and parameters match
     if (!g_sShadow) {
         // assign parameters
@@ -322,6 +389,9 @@ void Decoration::updateShadow()
 
         // assign image
         g_sShadow->setShadow(image);
+
+        g_shadowBytes = image.sizeInBytes();
+        Cutefish::Memory::allocated("decoration/shadow", Cutefish::Memory::Cpu, g_shadowBytes);
     }
 
     setShadow(g_sShadow);
@@ -329,22 +399,74 @@ void Decoration::updateShadow()
 
 void Decoration::updateBtnPixmap()
 {
-    int size = 24;
-    QString dirName = darkMode() ? "dark" : "light";
+    // Rasterized again on the next paint of each output.
+    for (qreal scale : m_btnPixmaps.keys())
+        releaseBtnPixmaps(scale);
+}
 
-    m_closeBtnPixmap = fromSvgToPixmap(QString(":/images/%1/close_normal.svg").arg(dirName), QSize(size, size));
-    m_maximizeBtnPixmap = fromSvgToPixmap(QString(":/images/%1/maximize_normal.svg").arg(dirName), QSize(size, size));
-    m_minimizeBtnPixmap = fromSvgToPixmap(QString(":/images/%1/minimize_normal.svg").arg(dirName), QSize(size, size));
-    m_restoreBtnPixmap = fromSvgToPixmap(QString(":/images/%1/restore_normal.svg").arg(dirName), QSize(size, size));
+void Decoration::releaseBtnPixmaps(qreal scale)
+{
+    auto it = m_btnPixmaps.find(scale);
+    if (it == m_btnPixmaps.end())
+        return;
+
+    Cutefish::Memory::freed("decoration/button-pixmaps", Cutefish::Memory::Cpu, it.value().bytes());
+    m_btnPixmaps.erase(it);
+}
+
+void Decoration::releaseUnusedBtnPixmaps()
+{
+    QSet<qreal> scales;
+    for (QScreen *screen : QGuiApplication::screens())
+        scales.insert(screen->devicePixelRatio());
+
+    for (qreal scale : m_btnPixmaps.keys()) {
+        if (!scales.contains(scale))
+            releaseBtnPixmaps(scale);
+    }
 }
 
-QPixmap Decoration::fromSvgToPixmap(const QString &file, const QSize &size)
+qint64 Decoration::BtnPixmaps::bytes() const
+{
+    qint64 bytes = 0;
+    for (const QPixmap *pixmap : { &close, &maximize, &minimize, &restore })
+        bytes += qint64(pixmap->width()) * pixmap->height() * pixmap->depth() / 8;
+    return bytes;
+}
+
+const Decoration::BtnPixmaps &Decoration::btnPixmaps(qreal scale)
+{
+    auto it = m_btnPixmaps.find(scale);
+
+    if (it == m_btnPixmaps.end()) {
+        // updateBtnPixmap() only drops the cache, the work happens here.
+        CUTEFISH_TRACE_SCOPE("Decoration::updateBtnPixmap");
+
+        int size = 24;
+        QString dirName = darkMode() ? "dark" : "light";
+
+        BtnPixmaps pixmaps;
+        pixmaps.close = fromSvgToPixmap(QString(":/images/%1/close_normal.svg").arg(dirName), QSize(size, size), scale);
+        pixmaps.maximize = fromSvgToPixmap(QString(":/images/%1/maximize_normal.svg").arg(dirName), QSize(size, size), scale);
+        pixmaps.minimize = fromSvgToPixmap(QString(":/images/%1/minimize_normal.svg").arg(dirName), QSize(size, size), scale);
+        pixmaps.restore = fromSvgToPixmap(QString(":/images/%1/restore_normal.svg").arg(dirName), QSize(size, size), scale);
+        it = m_btnPixmaps.insert(scale, pixmaps);
+
+        Cutefish::Memory::allocated("decoration/button-pixmaps", Cutefish::Memory::Cpu, pixmaps.bytes());
+    }
+
+    return it.value();
+}
+
+QPixmap Decoration::fromSvgToPixmap(const QString &file, const QSize &size, qreal scale)
 {
     QImageReader reader(file);
 
     if (reader.canRead()) {
-        reader.setScaledSize(size * m_devicePixelRatio);
-        return QPixmap::fromImage(reader.read());
+        reader.setScaledSize(size * m_devicePixelRatio * scale);
+        QPixmap pixmap = QPixmap::fromImage(reader.read());
+        pixmap.setDevicePixelRatio(scale);
+        return pixmap;
     }
 
     return QPixmap();
@@ -361,8 +483,7 @@ int Decoration::titleBarHeight() const
 
 bool Decoration::darkMode() const
 {
-    QSettings settings(QSettings::UserScope, "cutefishos", "theme");
-    return settings.value("DarkMode", false).toBool();
+    return m_darkMode;
 }
 
 bool Decoration::radiusAvailable() const
@@ -371,6 +492,29 @@ bool Decoration::radiusAvailable() const
     // return client().toStrongRef().data()->adjacentScreenEdges() == Qt::Edges();
 }
 
+QPainterPath Decoration::frameBackgroundPath() const
+{
+    // Corners against a screen edge stay square, by the same rule as the
+    // roundedwindow effect.
+    const Cutefish::Corners corners = Cutefish::cornersClearOf(client().toStrongRef().data()->adjacentScreenEdges());
+    const bool squareTopLeft = !(corners & Cutefish::TopLeftCorner);
+    const bool squareTopRight = !(corners & Cutefish::TopRightCorner);
+
+    QPainterPath path;
+    path.addRoundedRect(rect(), m_frameRadius, m_frameRadius);
+
+    if (squareTopLeft || squareTopRight) {
+        QPainterPath squares;
+        if (squareTopLeft)
+            squares.addRect(QRect(rect().topLeft(), QSize(m_frameRadius, m_frameRadius)));
+        if (squareTopRight)
+            squares.addRect(QRect(rect().right() - m_frameRadius + 1, rect().top(), m_frameRadius, m_frameRadius));
+        path = path.united(squares);
+    }
+
+    return path;
+}
+
 bool Decoration::isMaximized() const
 {
     return client().toStrongRef().data()->isMaximized();
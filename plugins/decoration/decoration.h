@@ -24,12 +24,10 @@
 #include <KDecoration2/DecorationButtonGroup>
 
 // Qt
-#include <QFileSystemWatcher>
-#include <QSettings>
+#include <QHash>
 #include <QVariant>
 #include <QIcon>
-
-#include "x11shadow.h"
+#include <QPainterPath>
 
 namespace Cutefish
 {
@@ -48,10 +46,10 @@ public:
 
     void paint(QPainter *painter, const QRect &repaintRegion) override;
 
-    QPixmap closeBtnPixmap() { return m_closeBtnPixmap; }
-    QPixmap maximizeBtnPixmap() { return m_maximizeBtnPixmap; }
-    QPixmap minimizeBtnPixmap() { return m_minimizeBtnPixmap; }
-    QPixmap restoreBtnPixmap() { return m_restoreBtnPixmap; }
+    QPixmap closeBtnPixmap(qreal scale) { return btnPixmaps(scale).close; }
+    QPixmap maximizeBtnPixmap(qreal scale) { return btnPixmaps(scale).maximize; }
+    QPixmap minimizeBtnPixmap(qreal scale) { return btnPixmaps(scale).minimize; }
+    QPixmap restoreBtnPixmap(qreal scale) { return btnPixmaps(scale).restore; }
 
     bool darkMode() const;
     qreal devicePixelRatio() const { return m_devicePixelRatio; }
@@ -60,6 +58,15 @@ public slots:
     void init() override;
 
 private:
+    struct BtnPixmaps {
+        QPixmap close;
+        QPixmap maximize;
+        QPixmap minimize;
+        QPixmap restore;
+
+        qint64 bytes() const;
+    };
+
     void reconfigure();
     void createButtons();
     void recalculateBorders();
@@ -70,7 +77,10 @@ private:
     void updateShadow();
 
     void updateBtnPixmap();
-    QPixmap fromSvgToPixmap(const QString &file, const QSize &size);
+    void releaseBtnPixmaps(qreal scale);
+    void releaseUnusedBtnPixmaps();
+    const BtnPixmaps &btnPixmaps(qreal scale);
+    QPixmap fromSvgToPixmap(const QString &file, const QSize &size, qreal scale);
 
     int titleBarHeight() const;
 
@@ -78,6 +88,7 @@ private:
     QColor titleBarForegroundColor() const;
 
     bool radiusAvailable() const;
+    QPainterPath frameBackgroundPath() const;
     bool isMaximized() const;
 
     void paintFrameBackground(QPainter *painter, const QRect &repaintRegion) const;
@@ -95,6 +106,8 @@ private:
     int m_titleBarHeight = 30;
     int m_frameRadius = 11;
     qreal m_devicePixelRatio = 1.0;
+    // Read with the theme file, paint asks for it several times per frame.
+    bool m_darkMode = false;
     QColor m_titleBarBgColor = QColor(255, 255, 255, 255);
     QColor m_titleBarFgColor = QColor(56, 56, 56, 255);
     QColor m_unfocusedFgColor = QColor(127, 127, 127, 255);
@@ -103,16 +116,8 @@ private:
     QColor m_titleBarFgDarkColor = QColor(202, 203, 206);
     QColor m_unfocusedFgDarkColor = QColor(112, 112, 112);
 
-    QSettings *m_settings;
-    QString m_settingsFile;
-    QFileSystemWatcher *m_fileWatcher;
-
-    QPixmap m_closeBtnPixmap;
-    QPixmap m_maximizeBtnPixmap;
-    QPixmap m_minimizeBtnPixmap;
-    QPixmap m_restoreBtnPixmap;
-
-    X11Shadow *m_x11Shadow;
+    // Button rasters keyed by output scale, created for the scales in use.
+    QHash<qreal, BtnPixmaps> m_btnPixmaps;
 };
 
 }
@@ -19,39 +19,29 @@
  */
 
 #include "roundedwindow.h"
+#include "lowpower.h"
+#include "memoryaccounting.h"
+#include "powerprofile.h"
+#include "roundedrect.h"
+#include "windowcorners.h"
+#include "trace.h"
 
 // Qt
-#include <QFile>
-#include <QPainter>
-#include <QPainterPath>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QMatrix4x4>
 #include <QRegion>
 #include <QDebug>
 
 #include <QSettings>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QVector>
 
-Q_DECLARE_METATYPE(QPainterPath)
-
-typedef void (* SetDepth)(void *, int);
-static SetDepth setDepthfunc = nullptr;
-
-static QStringList allowList = { "netease-cloud-music netease-cloud-music",
-                                 "com.alibabainc.dingtalk com.alibabainc.dingtalk",
-                                 "tenvideo_universal tenvideo_universal",
-                                 "com.eusoft.ting.en com.eusoft.ting.en",
-                                 "i4toolslinux i4tools",
-                                 "youku-app youku-app",
-                                 "qqmusic qqmusic",
-                                 "mytime mytime",
-                                 "feishu feishu",
-                                 "bytedance-feishu bytedance-feishu",
-                                 "xmind xmind",
-                                 "mtxx mtxx",
-                                 "ynote-desktop ynote-desktop",
-
-                                 // Open source software
-                                 "code code",
-                                 "motrix motrix"
-                               };
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <algorithm>
 
 // From ubreffect
 static KWin::GLShader *getShader()
@@ -62,12 +52,15 @@ static KWin::GLShader *getShader()
 
     KWin::GLPlatform * const gl = KWin::GLPlatform::instance();
     QByteArray varying, output, textureLookup;
+    // Precision of the window space values, empty on desktop GL.
+    QByteArray highp;
 
     if (!gl->isGLES()) {
         const bool glsl_140 = gl->glslVersion() >= KWin::kVersionNumber(1, 40);
 
         if (glsl_140)
             stream << "#version 140\n\n";
+        stream << Cutefish::DesktopPrecision;
 
         varying       = glsl_140 ? QByteArrayLiteral("in")         : QByteArrayLiteral("varying");
         textureLookup = glsl_140 ? QByteArrayLiteral("texture")    : QByteArrayLiteral("texture2D");
@@ -81,7 +74,12 @@ static KWin::GLShader *getShader()
         // From the GLSL ES specification:
         //
         //     "The fragment language has no default precision qualifier for floating point types."
-        stream << "precision highp float;\n\n";
+        //
+        // Colors and the corner local distance fit in mediump, only window
+        // coordinates need more. highp is optional in GLES2 fragment shaders.
+        stream << Cutefish::GlesPrecision;
+
+        highp = QByteArrayLiteral("HIGHP ");
 
         varying       = glsl_es_300 ? QByteArrayLiteral("in")         : QByteArrayLiteral("varying");
         textureLookup = glsl_es_300 ? QByteArrayLiteral("texture")    : QByteArrayLiteral("texture2D");
@@ -97,24 +95,24 @@ static KWin::GLShader *getShader()
     if (traits & KWin::ShaderTrait::MapTexture) {
         stream << "uniform sampler2D sampler;\n";
 
-        // custom texture
-        stream << "uniform sampler2D topleft;\n";
-        stream << "uniform sampler2D topright;\n";
-        stream << "uniform sampler2D bottomleft;\n";
-        stream << "uniform sampler2D bottomright;\n";
+        // window size in logical pixels, the mask is computed in this space
+        stream << "uniform " << highp << "vec2 windowSize;\n";
+        stream << "uniform float radius;\n";
+        // size of one output pixel in window space, the antialiasing width
+        stream << "uniform float pixelSize;\n";
 
-        // scale
-        stream << "uniform vec2 scale;\n";
-        stream << "uniform vec2 scale1;\n";
-        stream << "uniform vec2 scale2;\n";
-        stream << "uniform vec2 scale3;\n";
+        // per-corner enable flags: top-left, top-right, bottom-left, bottom-right
+        stream << "uniform vec4 corners;\n";
 
         if (traits & KWin::ShaderTrait::Modulate)
             stream << "uniform vec4 modulation;\n";
         if (traits & KWin::ShaderTrait::AdjustSaturation)
             stream << "uniform float saturation;\n";
 
-        stream << "\n" << varying << " vec2 texcoord0;\n";
+        stream << "\n" << varying << " " << highp << "vec2 texcoord0;\n";
+
+        if (!gl->isGLES())
+            stream << "\n" << Cutefish::RoundedRectSdf;
 
     } else if (traits & KWin::ShaderTrait::UniformColor)
         stream << "uniform vec4 geometryColor;\n";
@@ -130,35 +128,32 @@ static KWin::GLShader *getShader()
 
     stream << "\nvoid main(void)\n{\n";
     if (traits & KWin::ShaderTrait::MapTexture) {
-        stream << "vec2 texcoordC = texcoord0;\n";
-
-
-        stream << "    " << "vec4 var;\n";
-        stream << "if (texcoordC.x < 0.5) {\n"
-                  "    if (texcoordC.y < 0.5) {\n"
-                  "        vec2 cornerCoord = vec2(texcoordC.x * scale.x, texcoordC.y * scale.y);\n"
-                  "        var = " << textureLookup << "(topleft, cornerCoord);\n"
-                  "    } else {\n"
-                  "        vec2 cornerCoordBL = vec2(texcoordC.x * scale2.x, (1.0 - texcoordC.y) * scale2.y);\n"
-                  "        var = " << textureLookup << "(bottomleft, cornerCoordBL);\n"
-                  "    }\n"
-                  "} else {\n"
-                  "    if (texcoordC.y < 0.5) {\n"
-                  "        vec2 cornerCoordTR = vec2((1.0 - texcoordC.x) * scale1.x, texcoordC.y * scale1.y);\n"
-                  "        var = " << textureLookup << "(topright, cornerCoordTR);\n"
-                  "    } else {\n"
-                  "        vec2 cornerCoordBR = vec2((1.0 - texcoordC.x) * scale3.x, (1.0 - texcoordC.y) * scale3.y);\n"
-                  "        var = " << textureLookup << "(bottomright, cornerCoordBR);\n"
-                  "    }\n"
-                  "}\n";
-
-        stream << "    vec4 texel = " << textureLookup << "(sampler, texcoordC);\n";
+        // Texture coordinates span the window whatever WindowPaintData does
+        // to it, so the mask follows every scale and translation.
+        if (!gl->isGLES()) {
+            stream << "    vec2 p = texcoord0 * windowSize;\n"
+                      "    vec2 side = step(windowSize * 0.5, p);\n"
+                      "    float r = radius * mix(mix(corners.x, corners.y, side.x), mix(corners.z, corners.w, side.x), side.y);\n"
+                      "    float coverage = clamp(0.5 - roundedRectSdf(p, vec4(vec2(0.0), windowSize), r) / pixelSize, 0.0, 1.0);\n";
+        } else {
+            // Same distance as roundedRectSdf, but the window space part stays
+            // in highp and only the corner local rest runs in mediump.
+            stream << "    HIGHP vec2 p = texcoord0 * windowSize;\n"
+                      "    HIGHP vec2 halfSize = windowSize * 0.5;\n"
+                      "    vec2 side = step(halfSize, p);\n"
+                      "    float r = radius * mix(mix(corners.x, corners.y, side.x), mix(corners.z, corners.w, side.x), side.y);\n"
+                      "    vec2 q = abs(p - halfSize) - halfSize + vec2(r);\n"
+                      "    float dist = min(max(q.x, q.y), 0.0) + length(max(q, 0.0)) - r;\n"
+                      "    float coverage = clamp(0.5 - dist / pixelSize, 0.0, 1.0);\n";
+        }
+
+        stream << "    vec4 texel = " << textureLookup << "(sampler, texcoord0);\n";
         if (traits & KWin::ShaderTrait::Modulate)
             stream << "    texel *= modulation;\n";
         if (traits & KWin::ShaderTrait::AdjustSaturation)
             stream << "    texel.rgb = mix(vec3(dot(texel.rgb, vec3(0.2126, 0.7152, 0.0722))), texel.rgb, saturation);\n";
 
-        stream << "    " << output << " = texel * var;\n";
+        stream << "    " << output << " = texel * coverage;\n";
     } else if (traits & KWin::ShaderTrait::UniformColor)
         stream << "    " << output << " = geometryColor;\n";
 
@@ -170,59 +165,544 @@ static KWin::GLShader *getShader()
     return shader;
 }
 
-static KWin::GLTexture *getTexture(int borderRadius)
+// Gaussian shadow of a rounded rect in closed form: erf along x, and a
+// four-sample integral along y. See Evan Wallace, "Fast Rounded Rectangle
+// Shadows".
+static const char s_shadowSource[] =
+    "uniform HIGHP vec4 windowRect;\n"
+    "uniform float radius;\n"
+    "uniform float sigma;\n"
+    "uniform vec2 offset;\n"
+    "uniform float strength;\n"
+    "\n"
+    "varying HIGHP vec2 texcoord0;\n"
+    "\n"
+    "float gaussian(float x, float sigma)\n"
+    "{\n"
+    "    return exp(-(x * x) / (2.0 * sigma * sigma)) / (2.5066283 * sigma);\n"
+    "}\n"
+    "\n"
+    "vec2 erf(vec2 x)\n"
+    "{\n"
+    "    vec2 s = sign(x), a = abs(x);\n"
+    "    x = 1.0 + (0.278393 + (0.230389 + 0.078108 * (a * a)) * a) * a;\n"
+    "    x *= x;\n"
+    "    return s - s / (x * x);\n"
+    "}\n"
+    "\n"
+    "float shadowX(HIGHP float x, HIGHP float y, float sigma, float corner, HIGHP vec2 halfSize)\n"
+    "{\n"
+    "    float delta = min(halfSize.y - corner - abs(y), 0.0);\n"
+    "    HIGHP float curved = halfSize.x - corner + sqrt(max(0.0, corner * corner - delta * delta));\n"
+    "    vec2 integral = 0.5 + 0.5 * erf((x + vec2(-curved, curved)) * (0.7071068 / sigma));\n"
+    "    return integral.y - integral.x;\n"
+    "}\n"
+    "\n"
+    "float roundedRectShadow(HIGHP vec2 lower, HIGHP vec2 upper, HIGHP vec2 p, float sigma, float corner)\n"
+    "{\n"
+    "    HIGHP vec2 center = (lower + upper) * 0.5;\n"
+    "    HIGHP vec2 halfSize = (upper - lower) * 0.5;\n"
+    "    p -= center;\n"
+    "\n"
+    "    HIGHP float low = p.y - halfSize.y;\n"
+    "    HIGHP float high = p.y + halfSize.y;\n"
+    "    float start = clamp(-3.0 * sigma, low, high);\n"
+    "    float end = clamp(3.0 * sigma, low, high);\n"
+    "\n"
+    "    float step = (end - start) / 4.0;\n"
+    "    float y = start + step * 0.5;\n"
+    "    float value = 0.0;\n"
+    "    for (int i = 0; i < 4; i++) {\n"
+    "        value += shadowX(p.x, p.y - y, sigma, corner, halfSize) * gaussian(y, sigma) * step;\n"
+    "        y += step;\n"
+    "    }\n"
+    "    return value;\n"
+    "}\n"
+    "\n"
+    "ROUNDED_RECT_SDF"
+    "\n"
+    "void main(void)\n"
+    "{\n"
+    "    HIGHP vec2 lower = windowRect.xy + offset;\n"
+    "    float shadow = roundedRectShadow(lower, lower + windowRect.zw, texcoord0, sigma, radius);\n"
+    "    // Nothing under the window itself, it may be translucent.\n"
+    "    float outside = clamp(0.5 + roundedRectSdf(texcoord0, windowRect, radius), 0.0, 1.0);\n"
+    "    gl_FragColor = vec4(0.0, 0.0, 0.0, shadow * outside * strength);\n"
+    "}\n";
+
+static KWin::GLShader *getShadowShader()
+{
+    KWin::GLPlatform * const gl = KWin::GLPlatform::instance();
+    QByteArray source;
+    bool modern;
+
+    if (!gl->isGLES()) {
+        modern = gl->glslVersion() >= KWin::kVersionNumber(1, 40);
+        if (modern)
+            source += "#version 140\n\n";
+        source += Cutefish::DesktopPrecision;
+    } else {
+        modern = gl->glslVersion() >= KWin::kVersionNumber(3, 0);
+        if (modern)
+            source += "#version 300 es\n\n";
+        source += Cutefish::GlesPrecision;
+    }
+
+    QByteArray main = s_shadowSource;
+    main.replace("ROUNDED_RECT_SDF", Cutefish::RoundedRectSdf);
+    if (modern) {
+        main.replace("varying ", "in ");
+        main.replace("gl_FragColor", "fragColor");
+        source += "out vec4 fragColor;\n\n";
+    }
+    source += main;
+
+    // Only the vertex stage of MapTexture is used: texcoord0 carries the
+    // position in window coordinates.
+    return KWin::ShaderManager::instance()->generateCustomShader(KWin::ShaderTrait::MapTexture, QByteArray(), source);
+}
+
+// Appends two triangles covering rect, with tex as texture coordinates.
+static void appendQuad(QVector<float> &vertices, QVector<float> &texcoords, const QRectF &rect, const QRectF &tex)
+{
+    const float x0 = rect.left(), y0 = rect.top(), x1 = rect.x() + rect.width(), y1 = rect.y() + rect.height();
+    const float u0 = tex.left(), v0 = tex.top(), u1 = tex.x() + tex.width(), v1 = tex.y() + tex.height();
+
+    vertices << x0 << y0 << x1 << y0 << x1 << y1
+             << x0 << y0 << x1 << y1 << x0 << y1;
+    texcoords << u0 << v0 << u1 << v0 << u1 << v1
+              << u0 << v0 << u1 << v1 << u0 << v1;
+}
+
+// The calibration draws a window of this size, runs times per strategy.
+static const QSize s_calibrationSize(1024, 768);
+static const int s_calibrationRuns = 20;
+// After the session has started, the first calibration runs this late.
+static const int s_calibrationDelay = 10000;
+
+// Popup latencies kept for debug("popups").
+static const int s_popupLatencySamples = 256;
+
+// Above this the corner region path draws through the mask shader instead,
+// see drawWindow().
+static const int s_maxScissorRects = 12;
+
+// Scissors the draws in its scope to rects in screen coordinates, within
+// whatever scissor KWin had set, and restores it afterwards.
+class ScissorScope
+{
+public:
+    ScissorScope()
+        : m_wasEnabled(glIsEnabled(GL_SCISSOR_TEST))
+    {
+        glGetIntegerv(GL_SCISSOR_BOX, m_box);
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    ~ScissorScope()
+    {
+        glScissor(m_box[0], m_box[1], m_box[2], m_box[3]);
+        if (!m_wasEnabled)
+            glDisable(GL_SCISSOR_TEST);
+    }
+
+    void set(const QRect &rect)
+    {
+        // The render target covers this part of the screen, bottom up.
+        const QRect screen = KWin::GLRenderTarget::virtualScreenGeometry();
+        const qreal scale = KWin::GLRenderTarget::virtualScreenScale();
+        const QRect local = rect.translated(-screen.topLeft());
+
+        QRect box(qRound(local.x() * scale), qRound((screen.height() - local.y() - local.height()) * scale),
+                  qRound(local.width() * scale), qRound(local.height() * scale));
+        if (m_wasEnabled)
+            box &= QRect(m_box[0], m_box[1], m_box[2], m_box[3]);
+
+        glScissor(box.x(), box.y(), qMax(0, box.width()), qMax(0, box.height()));
+    }
+
+private:
+    Q_DISABLE_COPY(ScissorScope)
+
+    const bool m_wasEnabled;
+    GLint m_box[4];
+};
+
+static const char *clipStrategyName(RoundedWindow::ClipStrategy strategy)
 {
-    QPixmap pix(QSize(borderRadius, borderRadius));
-    pix.fill(Qt::transparent);
-    QPainter painter(&pix);
-    painter.setRenderHint(QPainter::Antialiasing);
-    QPainterPath path;
-    path.moveTo(borderRadius, 0);
-    path.arcTo(0, 0, 2 * borderRadius, 2 * borderRadius, 90, 90);
-    path.lineTo(borderRadius, borderRadius);
-    path.lineTo(borderRadius, 0);
-    painter.fillPath(path, Qt::white);
+    return strategy == RoundedWindow::CornerRegionClip ? "CornerRegion" : "MaskShader";
+}
 
-    auto texture = new KWin::GLTexture(pix);
-    texture->setFilter(GL_LINEAR);
-    texture->setWrapMode(GL_CLAMP_TO_BORDER);
+static bool clipStrategyFromName(const QString &name, RoundedWindow::ClipStrategy *strategy)
+{
+    if (name == QLatin1String("MaskShader"))
+        *strategy = RoundedWindow::MaskShaderClip;
+    else if (name == QLatin1String("CornerRegion"))
+        *strategy = RoundedWindow::CornerRegionClip;
+    else
+        return false;
 
-    return texture;
+    return true;
 }
 
 RoundedWindow::RoundedWindow(QObject *, const QVariantList &)
     : KWin::Effect()
 {
-    QSettings settings(QSettings::UserScope, "cutefishos", "theme");
-    qreal devicePixelRatio = settings.value("PixelRatio", 1.0).toReal();
-    m_frameRadius = 11 * devicePixelRatio;
+    // Everything else waits for the first window painted, see init().
+    connect(KWin::effects, &KWin::EffectsHandler::windowFrameGeometryChanged, this, &RoundedWindow::slotWindowFrameGeometryChanged);
+    connect(KWin::effects, &KWin::EffectsHandler::windowMinimized, this, &RoundedWindow::slotRepaintShadow);
+    connect(KWin::effects, &KWin::EffectsHandler::windowDeleted, this, &RoundedWindow::slotRepaintShadow);
+    connect(KWin::effects, &KWin::EffectsHandler::windowAdded, this, &RoundedWindow::slotWindowAdded);
+    Cutefish::trackMaximizeState(this);
+    connect(KWin::effects, &KWin::EffectsHandler::windowDeleted, this, [this](KWin::EffectWindow *w) {
+        m_pendingPopups.remove(w);
+    });
+
+    // Until init() reads the override or the calibration.
+    m_preferredClipStrategy = fallbackClipStrategy();
+    updateClipStrategy();
+
+    Cutefish::Memory::exportReport();
+}
+
+RoundedWindow::~RoundedWindow()
+{
+    // KWin destroys the effects before it tears down the GL context on a
+    // compositor restart or a context reset, so this is the last chance to
+    // free the GPU side.
+    KWin::effects->makeOpenGLContextCurrent();
+
+    if (m_shader)
+        Cutefish::Memory::freed("roundedwindow/shaders", Cutefish::Memory::Gpu, 0);
+    if (m_shadowShader)
+        Cutefish::Memory::freed("roundedwindow/shaders", Cutefish::Memory::Gpu, 0);
+
+    delete m_shader;
+    m_shader = nullptr;
+    delete m_shadowShader;
+    m_shadowShader = nullptr;
+}
+
+void RoundedWindow::init()
+{
+    CUTEFISH_TRACE_SCOPE("RoundedWindow::init");
 
-    setDepthfunc = (SetDepth) QLibrary::resolve("kwin.so." + qApp->applicationVersion(), "_ZN4KWin8Toplevel8setDepthEi");
+    m_initialized = true;
 
-    QString name = "_NET_WM_STATE";
-    xcb_intern_atom_cookie_t cookie = xcb_intern_atom_unchecked(KWin::connection(), false, name.length(), name.toUtf8());
-    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(KWin::connection(), cookie, nullptr);
-    m_netWMStateAtom = reply->atom;
-    free(reply);
+    m_settings = new QSettings(QSettings::UserScope, "cutefishos", "theme", this);
+    m_fileWatcher = new QFileSystemWatcher(this);
 
-    name = "_NET_WM_STATE_MAXIMIZED_HORZ";
-    cookie = xcb_intern_atom_unchecked(KWin::connection(), false, name.length(), name.toUtf8());
-    reply = xcb_intern_atom_reply(KWin::connection(), cookie, nullptr);
-    m_netWMStateMaxHorzAtom = reply->atom;
-    free(reply);
+    reconfigure(ReconfigureAll);
 
-    name = "_NET_WM_STATE_MAXIMIZED_VERT";
-    cookie = xcb_intern_atom_unchecked(KWin::connection(), false, name.length(), name.toUtf8());
-    reply = xcb_intern_atom_reply(KWin::connection(), cookie, nullptr);
-    m_netWMStateMaxVertAtom = reply->atom;
-    free(reply);
+    // This runs inside a paint pass, only the settings are read here and
+    // the shader is built by the first drawWindow(). The rest waits for
+    // the event loop.
+    QTimer::singleShot(0, this, &RoundedWindow::slotInitIdle);
 
-    m_shader = getShader();
-    m_texure = getTexture(m_frameRadius);
+    // The radius follows the theme PixelRatio without reloading KWin.
+    m_fileWatcher->addPath(m_settings->fileName());
+    connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, [this] {
+        reconfigure(ReconfigureAll);
+
+        if (!m_fileWatcher->files().contains(m_settings->fileName()))
+            m_fileWatcher->addPath(m_settings->fileName());
+    });
 }
 
-RoundedWindow::~RoundedWindow()
+void RoundedWindow::slotInitIdle()
+{
+    CUTEFISH_TRACE_SCOPE("RoundedWindow::initIdle");
+
+    m_powerProfile = new Cutefish::PowerProfile(this);
+
+    connect(m_powerProfile, &Cutefish::PowerProfile::changed, this, &RoundedWindow::slotPowerProfileChanged);
+    slotPowerProfileChanged();
+}
+
+void RoundedWindow::reconfigure(ReconfigureFlags flags)
+{
+    Q_UNUSED(flags)
+    CUTEFISH_TRACE_SCOPE("RoundedWindow::reconfigure");
+
+    // init() reads everything once it runs.
+    if (!m_initialized)
+        return;
+
+    if (m_powerProfile)
+        Cutefish::handOffLowPower(m_powerProfile->isLowPower());
+
+    m_settings->sync();
+    const qreal ratio = m_settings->value("PixelRatio", 1.0).toReal();
+    const int frameRadius = Cutefish::FrameRadius * ratio;
+
+    // The decoration reads AnalyticShadow too and drops its own shadow.
+    KConfigGroup config = KWin::effects->effectConfig(QStringLiteral("roundedwindow"));
+    const bool shadowEnabled = config.readEntry("AnalyticShadow", false);
+    const int shadowSize = qMax(1, config.readEntry("ShadowSize", 30)) * ratio;
+    const int shadowStrength = qBound(0, config.readEntry("ShadowStrength", 35), 255);
+
+    if (frameRadius != m_frameRadius || shadowEnabled != m_shadowEnabled
+            || shadowSize != m_shadowSize || shadowStrength != m_shadowStrength) {
+        m_frameRadius = frameRadius;
+        m_shadowEnabled = shadowEnabled;
+        m_shadowSize = shadowSize;
+        m_shadowStrength = shadowStrength;
+        KWin::effects->addRepaintFull();
+    }
+
+    // Auto, MaskShader or CornerRegion. Auto uses the fastest strategy
+    // measured on this GPU and driver.
+    const QString clipStrategy = config.readEntry("ClipStrategy", QStringLiteral("Auto"));
+    ClipStrategy preferred;
+    if (clipStrategyFromName(clipStrategy, &preferred)) {
+        m_clipStrategyOrigin = "override";
+    } else if (m_calibrated || cachedClipStrategy(&m_calibratedClipStrategy)) {
+        m_calibrated = true;
+        preferred = m_calibratedClipStrategy;
+        m_clipStrategyOrigin = "calibrated";
+    } else {
+        preferred = fallbackClipStrategy();
+        m_clipStrategyOrigin = "default";
+
+        // Measuring takes dozens of full window draws, far too long for
+        // the frame that loaded the effect.
+        if (!m_calibrationPending) {
+            m_calibrationPending = true;
+            QTimer::singleShot(s_calibrationDelay, this, &RoundedWindow::slotCalibrate);
+        }
+    }
+
+    if (preferred != m_preferredClipStrategy) {
+        m_preferredClipStrategy = preferred;
+        updateClipStrategy();
+        KWin::effects->addRepaintFull();
+    }
+}
+
+RoundedWindow::ClipStrategy RoundedWindow::fallbackClipStrategy()
+{
+    // llvmpipe, softpipe and swrast run every fragment op on the CPU.
+    return KWin::GLPlatform::instance()->isSoftwareEmulation() ? CornerRegionClip : MaskShaderClip;
+}
+
+static QByteArray calibrationDriver()
+{
+    KWin::GLPlatform * const gl = KWin::GLPlatform::instance();
+    return gl->glRendererString() + ' ' + gl->glVersionString();
+}
+
+// One group per renderer and driver version, a driver update measures
+// again.
+static KConfigGroup calibrationGroup()
+{
+    KSharedConfig::Ptr cache = KSharedConfig::openConfig(QStringLiteral("cutefish-roundedwindowrc"),
+                                                         KConfig::SimpleConfig, QStandardPaths::GenericCacheLocation);
+    return cache->group(QString::fromLatin1(QCryptographicHash::hash(calibrationDriver(), QCryptographicHash::Sha1).toHex()));
+}
+
+bool RoundedWindow::cachedClipStrategy(ClipStrategy *strategy)
+{
+    return clipStrategyFromName(calibrationGroup().readEntry("Strategy", QString()), strategy);
+}
+
+void RoundedWindow::slotCalibrate()
+{
+    m_calibrationPending = false;
+
+    // The override was set, or the compositor went away, meanwhile.
+    if (m_calibrated || qstrcmp(m_clipStrategyOrigin, "default") != 0 || !KWin::effects->isOpenGLCompositing())
+        return;
+
+    CUTEFISH_TRACE_SCOPE("RoundedWindow::calibrate");
+
+    KWin::effects->makeOpenGLContextCurrent();
+    ClipStrategy strategy;
+    const bool measured = calibrateClipStrategy(&strategy);
+    KWin::effects->doneOpenGLContextCurrent();
+
+    if (!measured)
+        return;
+
+    m_calibrated = true;
+    m_calibratedClipStrategy = strategy;
+    m_clipStrategyOrigin = "calibrated";
+
+    if (strategy != m_preferredClipStrategy) {
+        m_preferredClipStrategy = strategy;
+        updateClipStrategy();
+        KWin::effects->addRepaintFull();
+    }
+}
+
+bool RoundedWindow::calibrateClipStrategy(ClipStrategy *strategy)
+{
+    if (!ensureShader() || !KWin::GLRenderTarget::supported())
+        return false;
+
+    KWin::GLTexture source(GL_RGBA8, s_calibrationSize);
+    KWin::GLTexture targetTexture(GL_RGBA8, s_calibrationSize);
+    KWin::GLRenderTarget target(targetTexture);
+    if (!target.valid())
+        return false;
+
+    KWin::GLRenderTarget::pushRenderTarget(&target);
+    source.bind();
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // The first draws also pay for shader and texture setup.
+    benchmark(MaskShaderClip, 1);
+    benchmark(CornerRegionClip, 1);
+
+    const qint64 maskShaderTime = benchmark(MaskShaderClip, s_calibrationRuns);
+    const qint64 cornerRegionTime = benchmark(CornerRegionClip, s_calibrationRuns);
+
+    glDisable(GL_BLEND);
+    source.unbind();
+    KWin::GLRenderTarget::popRenderTarget();
+
+    *strategy = cornerRegionTime < maskShaderTime ? CornerRegionClip : MaskShaderClip;
+
+    KConfigGroup group = calibrationGroup();
+    group.writeEntry("Renderer", QString::fromUtf8(calibrationDriver()));
+    group.writeEntry("MaskShaderTime", maskShaderTime);
+    group.writeEntry("CornerRegionTime", cornerRegionTime);
+    group.writeEntry("Strategy", clipStrategyName(*strategy));
+    group.sync();
+
+    return true;
+}
+
+qint64 RoundedWindow::benchmark(ClipStrategy strategy, int runs)
+{
+    const QRect window(QPoint(0, 0), s_calibrationSize);
+    const QSizeF size(s_calibrationSize);
+    const int radius = qMax(1, m_frameRadius);
+
+    QRegion masked = window;
+    if (strategy == CornerRegionClip) {
+        masked = QRect(0, 0, radius, radius);
+        masked += QRect(window.right() - radius + 1, 0, radius, radius);
+        masked += QRect(0, window.bottom() - radius + 1, radius, radius);
+        masked += QRect(window.right() - radius + 1, window.bottom() - radius + 1, radius, radius);
+    }
+
+    // Texture coordinates are normalized, like a window's.
+    QVector<float> plainVertices, plainTexcoords, maskedVertices, maskedTexcoords;
+    for (const QRect &rect : QRegion(window) - masked) {
+        appendQuad(plainVertices, plainTexcoords, rect,
+                   QRectF(rect.x() / size.width(), rect.y() / size.height(), rect.width() / size.width(), rect.height() / size.height()));
+    }
+    for (const QRect &rect : masked) {
+        appendQuad(maskedVertices, maskedTexcoords, rect,
+                   QRectF(rect.x() / size.width(), rect.y() / size.height(), rect.width() / size.width(), rect.height() / size.height()));
+    }
+
+    QMatrix4x4 projection;
+    projection.ortho(0, size.width(), 0, size.height(), 0, 65535);
+
+    KWin::GLVertexBuffer *vbo = KWin::GLVertexBuffer::streamingBuffer();
+
+    glFinish();
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < runs; ++i) {
+        if (!plainVertices.isEmpty()) {
+            KWin::ShaderBinder binder(KWin::ShaderTrait::MapTexture);
+            binder.shader()->setUniform(KWin::GLShader::ModelViewProjectionMatrix, projection);
+
+            vbo->reset();
+            vbo->setUseColor(false);
+            vbo->setData(plainVertices.count() / 2, 2, plainVertices.constData(), plainTexcoords.constData());
+            vbo->render(GL_TRIANGLES);
+        }
+
+        KWin::ShaderManager::instance()->pushShader(m_shader);
+        m_shader->setUniform(KWin::GLShader::ModelViewProjectionMatrix, projection);
+        m_shader->setUniform("modulation", QVector4D(1.0, 1.0, 1.0, 1.0));
+        m_shader->setUniform("saturation", 1.0f);
+        m_shader->setUniform("corners", QVector4D(1.0, 1.0, 1.0, 1.0));
+        m_shader->setUniform("windowSize", QVector2D(size.width(), size.height()));
+        m_shader->setUniform("radius", float(radius));
+        m_shader->setUniform("pixelSize", 1.0f);
+
+        vbo->reset();
+        vbo->setUseColor(false);
+        vbo->setData(maskedVertices.count() / 2, 2, maskedVertices.constData(), maskedTexcoords.constData());
+        vbo->render(GL_TRIANGLES);
+
+        KWin::ShaderManager::instance()->popShader();
+    }
+
+    // Wait for the GPU, the calls above only queue the work.
+    glFinish();
+    return timer.nsecsElapsed();
+}
+
+QString RoundedWindow::debug(const QString &parameter) const
+{
+    if (parameter == QLatin1String("trace"))
+        return QString::fromUtf8(Cutefish::Trace::dumpChromeJson());
+    if (parameter == QLatin1String("memory"))
+        return Cutefish::Memory::report();
+    if (parameter == QLatin1String("popups"))
+        return popupLatencyReport();
+
+    QString info;
+    QTextStream stream(&info);
+    stream << "initialized: " << (m_initialized ? "yes" : "no") << "\n"
+           << "radius: " << m_frameRadius << "\n"
+           << "clip strategy: " << (m_clipStrategy == CornerRegionClip ? "corner region" : "mask shader")
+           << " (preferred " << clipStrategyName(m_preferredClipStrategy) << ", " << m_clipStrategyOrigin << ")\n"
+           << "shader: " << (m_shader && m_shader->isValid() ? "valid" : "none") << "\n"
+           << "analytic shadow: " << (m_shadowEnabled ? "on" : "off") << " (size " << m_shadowSize
+           << ", strength " << m_shadowStrength << ")\n";
+    if (m_powerProfile) {
+        stream << "power profile: " << (m_powerProfile->profile().isEmpty() ? QStringLiteral("none") : m_powerProfile->profile())
+               << ", on battery: " << (m_powerProfile->onBattery() ? "yes" : "no")
+               << ", low power: " << (m_powerProfile->isLowPower() ? "yes" : "no") << "\n";
+    }
+    return info;
+}
+
+void RoundedWindow::updateClipStrategy()
+{
+    // On battery the corner squares are all that is worth shading.
+    if (m_powerProfile && m_powerProfile->isLowPower())
+        m_clipStrategy = CornerRegionClip;
+    else
+        m_clipStrategy = m_preferredClipStrategy;
+}
+
+void RoundedWindow::slotPowerProfileChanged()
+{
+    CUTEFISH_TRACE_SCOPE("RoundedWindow::powerProfileChanged");
+
+    Cutefish::handOffLowPower(m_powerProfile->isLowPower());
+
+    updateClipStrategy();
+    KWin::effects->addRepaintFull();
+}
+
+#if KWIN_EFFECT_API_VERSION >= 233
+bool RoundedWindow::blocksDirectScanout() const
 {
+    // Full screen windows are never rounded or made translucent, so a
+    // window that can be scanned out is painted untouched anyway.
+    return false;
+}
+#endif
+
+qreal RoundedWindow::screenScale(KWin::EffectWindow *w) const
+{
+#if KWIN_EFFECT_API_VERSION >= 233
+    if (KWin::EffectScreen *screen = w->screen())
+        return screen->devicePixelRatio();
+#else
+    Q_UNUSED(w)
+#endif
+    return 1.0;
 }
 
 bool RoundedWindow::supported()
@@ -251,126 +731,286 @@ bool RoundedWindow::hasShadow(KWin::WindowQuadList &qds)
 }
 #endif
 
-bool RoundedWindow::isMaximized(KWin::EffectWindow *w)
+void RoundedWindow::prePaintWindow(KWin::EffectWindow *w, KWin::WindowPrePaintData &data, std::chrono::milliseconds presentTime)
 {
-    if (m_netWMStateAtom == 0)
-        return false;
+    if (Q_UNLIKELY(!m_initialized))
+        init();
 
-    QByteArray rawAtomData = w->readProperty(m_netWMStateAtom, XCB_ATOM_ATOM, 32);
-    if (!rawAtomData.isEmpty()) {
-        for (int i = 0; i < rawAtomData.length(); i += sizeof(xcb_atom_t)) {
-            xcb_atom_t atom = static_cast<xcb_atom_t>(rawAtomData.data()[i]) + 512;
-            if (atom == m_netWMStateMaxHorzAtom || atom == m_netWMStateMaxVertAtom)
-                return true;
-        }
-    }
+    // Rounded corners blend with what is below, so a window without an
+    // alpha channel has to leave the opaque pass too.
+    if (!w->hasAlpha() && Cutefish::roundedCorners(w))
+        data.setTranslucent();
 
-    return false;
+    // The shadow lies outside the window, KWin only paints inside it.
+    if (hasAnalyticShadow(w))
+        data.paint += shadowRect(w->frameGeometry());
+
+    KWin::Effect::prePaintWindow(w, data, presentTime);
 }
 
 void RoundedWindow::drawWindow(KWin::EffectWindow *w, int mask, const QRegion &region, KWin::WindowPaintData &data)
 {
-    if (!w->isPaintingEnabled() || ((mask & PAINT_WINDOW_LANCZOS))) {
-        return KWin::Effect::drawWindow(w, mask, region, data);
-    }
+    CUTEFISH_TRACE_SCOPE("RoundedWindow::drawWindow");
 
-    if (isMaximized(w)) {
+    // Thumbnails are drawn without a pre-paint pass.
+    if (Q_UNLIKELY(!m_initialized))
+        init();
+
+    if (Q_UNLIKELY(!m_pendingPopups.isEmpty()))
+        notePopupFrame(w, data);
+
+    // Lanczos passes go through here too: the filter paints the window
+    // with a copy of data, data.shader included, not through drawWindow.
+    if (!w->isPaintingEnabled()) {
         return KWin::Effect::drawWindow(w, mask, region, data);
     }
 
-    if (KWin::effects->hasActiveFullScreenEffect() || w->isFullScreen()) {
+#if KWIN_EFFECT_API_VERSION < 233
+    // Decorated windows lose their shadow quads to the analytic shadow.
+    const bool shadowed = m_shadowEnabled ? w->hasDecoration() : hasShadow(data.quads);
+    if (!shadowed && !Cutefish::roundedAllowList().contains(w->windowClass())) {
         return KWin::Effect::drawWindow(w, mask, region, data);
     }
+#endif
 
-    if (w->isDesktop()
-            || w->isMenu()
-            || w->isDock()
-            || w->isPopupWindow()
-            || w->isPopupMenu()
-            #if KWIN_EFFECT_API_VERSION < 233
-                 || !hasShadow(data.quads)
-            #endif
-        ) {
-        if (!allowList.contains(w->windowClass()))
-            return KWin::Effect::drawWindow(w, mask, region, data);
+    // Nothing would end up rounded, keep the window on the opaque path.
+    const Corners corners = Cutefish::roundedCorners(w);
+    if (!corners) {
+        return KWin::Effect::drawWindow(w, mask, region, data);
     }
 
-    // 设置 alpha 通道混合
-    if (!w->hasAlpha()) {
-        if (setDepthfunc) {
-            setDepthfunc(w->parent(), 32);
+    if (hasAnalyticShadow(w))
+        drawShadow(w, mask, region, data);
+
+    // KWin does not clip an untransformed window to the region it is
+    // given, each part is scissored to its rects instead. The corner
+    // region is in screen coordinates, so it only lines up with the window
+    // when nothing transforms it.
+    if (m_clipStrategy == CornerRegionClip
+            && !(mask & (PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_TRANSFORMED))) {
+        const QRegion cornerArea = region & cornerRegion(w, corners);
+        const QRegion interior = region - cornerArea;
+
+        // Every rect draws the whole window again, a fragmented region is
+        // cheaper through the mask shader.
+        if (interior.rectCount() + cornerArea.rectCount() <= s_maxScissorRects) {
+            ScissorScope scissor;
+            for (const QRect &rect : interior) {
+                scissor.set(rect);
+                KWin::Effect::drawWindow(w, mask, rect, data);
+            }
+            for (const QRect &rect : cornerArea) {
+                scissor.set(rect);
+                drawMaskedWindow(w, mask, rect, data, corners);
+            }
+            return;
         }
     }
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    drawMaskedWindow(w, mask, region, data, corners);
+}
 
-    auto textureTopLeft = m_texure;
-    glActiveTexture(GL_TEXTURE10);
-    textureTopLeft->bind();
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-    glActiveTexture(GL_TEXTURE0);
+QRegion RoundedWindow::cornerRegion(KWin::EffectWindow *w, Corners corners) const
+{
+    const QRect geo = w->frameGeometry();
+    const QSize size(m_frameRadius, m_frameRadius);
+
+    QRegion region;
+    if (corners & Cutefish::TopLeftCorner)
+        region += QRect(geo.topLeft(), size);
+    if (corners & Cutefish::TopRightCorner)
+        region += QRect(QPoint(geo.right() - m_frameRadius + 1, geo.top()), size);
+    if (corners & Cutefish::BottomLeftCorner)
+        region += QRect(QPoint(geo.left(), geo.bottom() - m_frameRadius + 1), size);
+    if (corners & Cutefish::BottomRightCorner)
+        region += QRect(QPoint(geo.right() - m_frameRadius + 1, geo.bottom() - m_frameRadius + 1), size);
+    return region;
+}
 
-    auto textureTopRight = m_texure;
-    glActiveTexture(GL_TEXTURE11);
-    textureTopRight->bind();
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-    glActiveTexture(GL_TEXTURE0);
+void RoundedWindow::drawMaskedWindow(KWin::EffectWindow *w, int mask, const QRegion &region,
+                                     KWin::WindowPaintData &data, Corners corners)
+{
+    if (region.isEmpty())
+        return;
 
-    auto textureBottomLeft = m_texure;
-    glActiveTexture(GL_TEXTURE12);
-    textureBottomLeft->bind();
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-    glActiveTexture(GL_TEXTURE0);
+    if (!ensureShader()) {
+        KWin::Effect::drawWindow(w, mask, region, data);
+        return;
+    }
 
-    auto textureBottomRight = m_texure;
-    glActiveTexture(GL_TEXTURE13);
-    textureBottomRight->bind();
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     KWin::GLShader *oldShader = data.shader;
     data.shader = m_shader;
     KWin::ShaderManager::instance()->pushShader(m_shader);
 
-    m_shader->setUniform("topleft", 10);
-    m_shader->setUniform("scale", QVector2D(w->width() * 1.0 / textureTopLeft->width(),
-                                               w->height() * 1.0 / textureTopLeft->height()));
+    m_shader->setUniform("corners", QVector4D(corners.testFlag(Cutefish::TopLeftCorner) ? 1.0 : 0.0,
+                                              corners.testFlag(Cutefish::TopRightCorner) ? 1.0 : 0.0,
+                                              corners.testFlag(Cutefish::BottomLeftCorner) ? 1.0 : 0.0,
+                                              corners.testFlag(Cutefish::BottomRightCorner) ? 1.0 : 0.0));
 
-    m_shader->setUniform("topright", 11);
-    m_shader->setUniform("scale1", QVector2D(w->width() * 1.0 / textureTopRight->width(),
-                                                w->height() * 1.0 / textureTopRight->height()));
+    // One output pixel covers 1 / (output scale * paint scale) window pixels.
+    const qreal paintScale = qMax(data.xScale(), data.yScale()) * screenScale(w);
 
-    m_shader->setUniform("bottomleft", 12);
-    m_shader->setUniform("scale2", QVector2D(w->width() * 1.0 / textureBottomLeft->width(),
-                                                w->height() * 1.0 / textureBottomLeft->height()));
-
-    m_shader->setUniform("bottomright", 13);
-    m_shader->setUniform("scale3", QVector2D(w->width() * 1.0 / textureBottomRight->width(),
-                                                w->height() * 1.0 / textureBottomRight->height()));
+    m_shader->setUniform("windowSize", QVector2D(w->width(), w->height()));
+    m_shader->setUniform("radius", float(m_frameRadius));
+    m_shader->setUniform("pixelSize", float(1.0 / qMax(paintScale, 0.01)));
 
     KWin::Effect::drawWindow(w, mask, region, data);
     KWin::ShaderManager::instance()->popShader();
 
     data.shader = oldShader;
 
-    glActiveTexture(GL_TEXTURE10);
-    textureTopLeft->unbind();
-    glActiveTexture(GL_TEXTURE0);
+    glDisable(GL_BLEND);
+}
+
+bool RoundedWindow::ensureShader()
+{
+    // Compiled for the first window that needs it.
+    if (!m_shader) {
+        m_shader = getShader();
+        // Driver side size is unknown, only the count is tracked.
+        if (m_shader)
+            Cutefish::Memory::allocated("roundedwindow/shaders", Cutefish::Memory::Gpu, 0);
+    }
+
+    return m_shader && m_shader->isValid();
+}
+
+bool RoundedWindow::hasAnalyticShadow(KWin::EffectWindow *w) const
+{
+    if (!m_shadowEnabled)
+        return false;
+
+    if (!w->hasDecoration() && !Cutefish::roundedAllowList().contains(w->windowClass()))
+        return false;
+
+    // Maximized and full screen windows have no visible edge to shadow.
+    return Cutefish::roundedCorners(w);
+}
+
+QRect RoundedWindow::shadowRect(const QRect &frameGeometry) const
+{
+    // Three sigma covers all but 0.3% of the gaussian.
+    const int offset = m_frameRadius / 2;
+    return frameGeometry.adjusted(-m_shadowSize, -m_shadowSize + offset, m_shadowSize, m_shadowSize + offset);
+}
+
+void RoundedWindow::slotWindowFrameGeometryChanged(KWin::EffectWindow *w, const QRect &oldGeometry)
+{
+    if (!m_shadowEnabled)
+        return;
+
+    KWin::effects->addRepaint(shadowRect(oldGeometry));
+    KWin::effects->addRepaint(shadowRect(w->frameGeometry()));
+}
+
+// How long menus take from being mapped to their first frame drawn at full
+// opacity: the texture upload plus any fade cutefish_popups runs. The time
+// the application takes from the click to mapping the menu is not visible
+// here.
+void RoundedWindow::slotWindowAdded(KWin::EffectWindow *w)
+{
+    if (w->isPopupMenu() || w->isDropdownMenu() || w->isComboBox())
+        m_pendingPopups.insert(w, Cutefish::Trace::now());
+}
+
+void RoundedWindow::notePopupFrame(KWin::EffectWindow *w, const KWin::WindowPaintData &data)
+{
+    auto it = m_pendingPopups.find(w);
+    if (it == m_pendingPopups.end())
+        return;
+
+    // Still fading in.
+    if (data.opacity() < w->opacity())
+        return;
+
+    const qint64 mapped = it.value();
+    const qint64 latency = Cutefish::Trace::now() - mapped;
+    m_pendingPopups.erase(it);
+
+    if (Cutefish::Trace::enabled())
+        Cutefish::Trace::record("Popup::mapToOpaqueFrame", mapped, latency);
+
+    m_popupLatencies.append(latency);
+    if (m_popupLatencies.size() > s_popupLatencySamples)
+        m_popupLatencies.removeFirst();
+}
+
+QString RoundedWindow::popupLatencyReport() const
+{
+    QVector<qint64> sorted = m_popupLatencies;
+    std::sort(sorted.begin(), sorted.end());
+
+    QString info;
+    QTextStream stream(&info);
+    stream << "popups: " << sorted.size() << "\n";
+    if (!sorted.isEmpty()) {
+        const auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 1); };
+        stream << "map to opaque frame: median " << ms(sorted.at(sorted.size() / 2)) << " ms"
+               << ", p95 " << ms(sorted.at(sorted.size() * 95 / 100)) << " ms"
+               << ", max " << ms(sorted.last()) << " ms\n";
+    }
+    return info;
+}
+
+void RoundedWindow::slotRepaintShadow(KWin::EffectWindow *w)
+{
+    if (m_shadowEnabled)
+        KWin::effects->addRepaint(shadowRect(w->frameGeometry()));
+}
 
-    glActiveTexture(GL_TEXTURE11);
-    textureTopRight->unbind();
-    glActiveTexture(GL_TEXTURE0);
+void RoundedWindow::drawShadow(KWin::EffectWindow *w, int mask, const QRegion &region, const KWin::WindowPaintData &data)
+{
+    if (!m_shadowShader) {
+        m_shadowShader = getShadowShader();
+        if (m_shadowShader)
+            Cutefish::Memory::allocated("roundedwindow/shaders", Cutefish::Memory::Gpu, 0);
+    }
+
+    if (!m_shadowShader || !m_shadowShader->isValid())
+        return;
+
+    const QRect geo = w->frameGeometry();
+    const QRect shadow = shadowRect(geo);
+    const bool transformed = mask & (PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_TRANSFORMED);
+
+    // Positions on screen, texture coordinates in the window's own space.
+    QVector<float> vertices, texcoords;
+    if (transformed) {
+        const QRectF local = shadow.translated(-geo.topLeft());
+        const QRectF rect(geo.x() + data.xTranslation() + local.x() * data.xScale(),
+                          geo.y() + data.yTranslation() + local.y() * data.yScale(),
+                          local.width() * data.xScale(),
+                          local.height() * data.yScale());
+        appendQuad(vertices, texcoords, rect, local);
+    } else {
+        for (const QRect &rect : region & shadow)
+            appendQuad(vertices, texcoords, rect, rect.translated(-geo.topLeft()));
+    }
 
-    glActiveTexture(GL_TEXTURE12);
-    textureBottomLeft->unbind();
-    glActiveTexture(GL_TEXTURE0);
+    if (vertices.isEmpty())
+        return;
 
-    glActiveTexture(GL_TEXTURE13);
-    textureBottomRight->unbind();
-    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    KWin::ShaderManager::instance()->pushShader(m_shadowShader);
+    m_shadowShader->setUniform(KWin::GLShader::ModelViewProjectionMatrix, data.screenProjectionMatrix());
+    m_shadowShader->setUniform("windowRect", QVector4D(0, 0, geo.width(), geo.height()));
+    m_shadowShader->setUniform("radius", float(m_frameRadius));
+    m_shadowShader->setUniform("sigma", float(m_shadowSize / 3.0));
+    m_shadowShader->setUniform("offset", QVector2D(0, m_frameRadius / 2));
+    m_shadowShader->setUniform("strength", float(m_shadowStrength / 255.0 * data.opacity()));
+
+    KWin::GLVertexBuffer *vbo = KWin::GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setUseColor(false);
+    vbo->setData(vertices.count() / 2, 2, vertices.constData(), texcoords.constData());
+    vbo->render(GL_TRIANGLES);
+
+    KWin::ShaderManager::instance()->popShader();
 
     glDisable(GL_BLEND);
 }
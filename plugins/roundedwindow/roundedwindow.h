@@ -25,7 +25,17 @@
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
-#include <xcb/xcb_atom.h>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QSettings>
+#include <QVector>
+
+#include "corners.h"
+
+namespace Cutefish
+{
+class PowerProfile;
+}
 
 class RoundedWindow : public KWin::Effect
 {
@@ -34,12 +44,21 @@ class RoundedWindow : public KWin::Effect
 public:
     enum DataRole {
         BaseRole = KWin::DataRole::LanczosCacheRole + 100,
-        WindowRadiusRole = BaseRole + 1,
-        WindowClipPathRole = BaseRole + 2,
-        WindowMaskTextureRole = BaseRole + 3,
-        WindowDepthRole = BaseRole + 4
+        WindowRadiusRole = BaseRole + 1
+    };
+
+    enum ClipStrategy {
+        // Every fragment of the window goes through the mask shader.
+        MaskShaderClip,
+        // Only the four corner squares go through the mask shader, the
+        // interior is painted as a plain textured copy. Picked for software
+        // rasterizers, where each extra shader op is paid on the CPU, and
+        // in the low power profile.
+        CornerRegionClip
     };
 
+    typedef Cutefish::Corners Corners;
+
     RoundedWindow(QObject *parent = nullptr, const QVariantList &args = QVariantList());
     ~RoundedWindow();
 
@@ -47,19 +66,72 @@ public:
     static bool enabledByDefault();
 
     bool hasShadow(KWin::WindowQuadList &qds);
-    bool isMaximized(KWin::EffectWindow *w);
 
+    void reconfigure(ReconfigureFlags flags) override;
+    QString debug(const QString &parameter) const override;
+#if KWIN_EFFECT_API_VERSION >= 233
+    bool blocksDirectScanout() const override;
+#endif
+
+    void prePaintWindow(KWin::EffectWindow *w, KWin::WindowPrePaintData &data, std::chrono::milliseconds presentTime) override;
     void drawWindow(KWin::EffectWindow* w, int mask, const QRegion &region, KWin::WindowPaintData& data) override;
 
+private slots:
+    void slotWindowFrameGeometryChanged(KWin::EffectWindow *w, const QRect &oldGeometry);
+    void slotRepaintShadow(KWin::EffectWindow *w);
+    void slotWindowAdded(KWin::EffectWindow *w);
+    void slotInitIdle();
+    void slotCalibrate();
+    void slotPowerProfileChanged();
+
 private:
-    KWin::GLShader *m_shader;
-    KWin::GLTexture *m_texure;
+    void init();
+    void updateClipStrategy();
+    static ClipStrategy fallbackClipStrategy();
+    static bool cachedClipStrategy(ClipStrategy *strategy);
+    bool calibrateClipStrategy(ClipStrategy *strategy);
+    // Nanoseconds spent drawing runs calibration windows with strategy.
+    qint64 benchmark(ClipStrategy strategy, int runs);
+    bool ensureShader();
+    qreal screenScale(KWin::EffectWindow *w) const;
+
+    QRegion cornerRegion(KWin::EffectWindow *w, Corners corners) const;
+    void drawMaskedWindow(KWin::EffectWindow *w, int mask, const QRegion &region,
+                          KWin::WindowPaintData &data, Corners corners);
+
+    bool hasAnalyticShadow(KWin::EffectWindow *w) const;
+    QRect shadowRect(const QRect &frameGeometry) const;
+    void drawShadow(KWin::EffectWindow *w, int mask, const QRegion &region, const KWin::WindowPaintData &data);
+
+    void notePopupFrame(KWin::EffectWindow *w, const KWin::WindowPaintData &data);
+    QString popupLatencyReport() const;
+
+    bool m_initialized = false;
+    QSettings *m_settings = nullptr;
+    QFileSystemWatcher *m_fileWatcher = nullptr;
+    Cutefish::PowerProfile *m_powerProfile = nullptr;
+
+    KWin::GLShader *m_shader = nullptr;
+    KWin::GLShader *m_shadowShader = nullptr;
+
+    int m_frameRadius = 0;
+    ClipStrategy m_clipStrategy;
+    // Overridden by the low power profile, see updateClipStrategy().
+    ClipStrategy m_preferredClipStrategy;
+    const char *m_clipStrategyOrigin = "default";
+    bool m_calibrated = false;
+    bool m_calibrationPending = false;
+    ClipStrategy m_calibratedClipStrategy = MaskShaderClip;
 
-    xcb_atom_t m_netWMStateAtom = 0;
-    xcb_atom_t m_netWMStateMaxHorzAtom = 0;
-    xcb_atom_t m_netWMStateMaxVertAtom = 0;
+    // Drawn here instead of by the decoration, see [Effect-roundedwindow].
+    bool m_shadowEnabled = false;
+    int m_shadowSize = 0;
+    int m_shadowStrength = 0;
 
-    int m_frameRadius;
+    // Menus mapped but not yet drawn at full opacity, with the time they
+    // were mapped, and the latest latencies in microseconds.
+    QHash<const KWin::EffectWindow *, qint64> m_pendingPopups;
+    QVector<qint64> m_popupLatencies;
 };
 
 #endif
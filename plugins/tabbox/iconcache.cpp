@@ -0,0 +1,183 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "iconcache.h"
+#include "memoryaccounting.h"
+
+#include <QQuickWindow>
+#include <QSGTexture>
+
+// 4 MiB of decoded icons, about 64 icons at 128px.
+static const int s_imageCacheCost = 4 * 1024;
+// Textures kept per window, least recently used go first. Window provided
+// icons are keyed by QIcon::cacheKey, so they would pile up otherwise.
+static const int s_textureCacheSize = 128;
+static const int s_bucketSizes[] = { 16, 22, 32, 48, 64, 96, 128, 192, 256 };
+
+IconCache *IconCache::instance()
+{
+    static IconCache *s_instance = new IconCache;
+    return s_instance;
+}
+
+IconCache::IconCache(QObject *parent)
+    : QObject(parent)
+    , m_images(s_imageCacheCost)
+{
+    m_idleTimer.setInterval(0);
+    connect(&m_idleTimer, &QTimer::timeout, this, &IconCache::processQueue);
+
+    Cutefish::Memory::exportReport();
+}
+
+IconCache::CachedImage::CachedImage(const QImage &image)
+    : image(image)
+{
+    Cutefish::Memory::allocated("tabbox/icons", Cutefish::Memory::Cpu, image.sizeInBytes());
+}
+
+IconCache::CachedImage::~CachedImage()
+{
+    Cutefish::Memory::freed("tabbox/icons", Cutefish::Memory::Cpu, image.sizeInBytes());
+}
+
+int IconCache::bucketSize(int size)
+{
+    for (int bucket : s_bucketSizes) {
+        if (bucket >= size)
+            return bucket;
+    }
+
+    return s_bucketSizes[sizeof(s_bucketSizes) / sizeof(s_bucketSizes[0]) - 1];
+}
+
+QString IconCache::cacheKey(const QIcon &icon, int size, bool active)
+{
+    // Themed icons are shared between windows of the same application,
+    // window provided pixmaps are only shared by the same window.
+    const QString name = icon.name().isEmpty() ? QString::number(icon.cacheKey()) : icon.name();
+    return QStringLiteral("%1@%2%3").arg(name).arg(size).arg(active ? QStringLiteral(":active") : QString());
+}
+
+QImage IconCache::cachedImage(const QIcon &icon, int size, bool active)
+{
+    if (icon.isNull() || size <= 0)
+        return QImage();
+
+    CachedImage *cached = m_images.object(cacheKey(icon, bucketSize(size), active));
+    return cached ? cached->image : QImage();
+}
+
+void IconCache::request(const QIcon &icon, int size, bool active)
+{
+    enqueue(icon, size, active, true);
+}
+
+QSharedPointer<QSGTexture> IconCache::texture(QQuickWindow *window, const QImage &image)
+{
+    if (!window || image.isNull())
+        return {};
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        auto it = m_textures.find(window);
+        if (it == m_textures.end()) {
+            it = m_textures.insert(window, new TextureCache(s_textureCacheSize));
+
+            // The textures belong to the scene graph of the window.
+            connect(window, &QQuickWindow::sceneGraphInvalidated, this, [this, window] {
+                releaseTextures(window);
+            }, Qt::DirectConnection);
+            connect(window, &QObject::destroyed, this, [this, window] {
+                releaseTextures(window);
+            });
+        }
+
+        if (QSharedPointer<QSGTexture> *texture = (*it)->object(image.cacheKey()))
+            return *texture;
+    }
+
+    const qint64 bytes = qint64(image.width()) * image.height() * 4;
+    QSharedPointer<QSGTexture> texture(window->createTextureFromImage(image), [bytes](QSGTexture *texture) {
+        Cutefish::Memory::freed("tabbox/icon-textures", Cutefish::Memory::Gpu, bytes);
+        delete texture;
+    });
+    Cutefish::Memory::allocated("tabbox/icon-textures", Cutefish::Memory::Gpu, bytes);
+
+    QMutexLocker locker(&m_mutex);
+    if (TextureCache *textures = m_textures.value(window))
+        textures->insert(image.cacheKey(), new QSharedPointer<QSGTexture>(texture));
+    return texture;
+}
+
+void IconCache::preload(const QVariant &icon, int size, bool active)
+{
+    enqueue(icon.value<QIcon>(), size, active, false);
+}
+
+void IconCache::enqueue(const QIcon &icon, int size, bool active, bool urgent)
+{
+    if (icon.isNull() || size <= 0)
+        return;
+
+    // An item on screen waiting for its icon goes before idle preloading.
+    if (urgent)
+        m_queue.prepend({ icon, size, active });
+    else
+        m_queue.enqueue({ icon, size, active });
+
+    if (!m_idleTimer.isActive())
+        m_idleTimer.start();
+}
+
+void IconCache::processQueue()
+{
+    if (m_queue.isEmpty()) {
+        m_idleTimer.stop();
+        return;
+    }
+
+    const Request request = m_queue.dequeue();
+    const int size = bucketSize(request.size);
+    const QString key = cacheKey(request.icon, size, request.active);
+
+    // Preloaded and requested icons overlap, decode each only once.
+    if (m_images.contains(key))
+        return;
+
+    const QImage image = request.icon.pixmap(size, size, request.active ? QIcon::Active : QIcon::Normal).toImage();
+    if (image.isNull())
+        return;
+
+    m_images.insert(key, new CachedImage(image), qMax(1, int(image.sizeInBytes() / 1024)));
+    emit imageReady();
+}
+
+void IconCache::releaseTextures(QQuickWindow *window)
+{
+    TextureCache *textures;
+    {
+        QMutexLocker locker(&m_mutex);
+        textures = m_textures.take(window);
+    }
+
+    // Outside the lock, the last reference deletes the texture.
+    delete textures;
+}
@@ -0,0 +1,102 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QTimer>
+
+class QQuickWindow;
+class QSGTexture;
+
+// Process wide cache of decoded window icons, shared by every switcher
+// instance so reopening Alt+Tab never goes back to the icon theme.
+class IconCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static IconCache *instance();
+
+    // Icons are decoded at one of a few fixed sizes so items of slightly
+    // different size share the same entry.
+    static int bucketSize(int size);
+
+    // GUI thread only. Returns a null image on a miss, request() then
+    // decodes it and imageReady() tells when it is there.
+    QImage cachedImage(const QIcon &icon, int size, bool active);
+    void request(const QIcon &icon, int size, bool active);
+
+    // Safe to call from the render thread, it only uploads the image. A
+    // texture lives on while a node holds it, even once the cache has
+    // dropped it.
+    QSharedPointer<QSGTexture> texture(QQuickWindow *window, const QImage &image);
+
+    // Queues the icon to be decoded at idle time, one per event loop pass.
+    // size is in device pixels, as IconItem asks for it.
+    Q_INVOKABLE void preload(const QVariant &icon, int size, bool active = false);
+
+signals:
+    void imageReady();
+
+private:
+    explicit IconCache(QObject *parent = nullptr);
+
+    static QString cacheKey(const QIcon &icon, int size, bool active);
+
+    void enqueue(const QIcon &icon, int size, bool active, bool urgent);
+    void processQueue();
+    void releaseTextures(QQuickWindow *window);
+
+    struct Request {
+        QIcon icon;
+        int size;
+        bool active;
+    };
+
+    // Accounted for as long as the cache keeps it.
+    struct CachedImage {
+        explicit CachedImage(const QImage &image);
+        ~CachedImage();
+
+        QImage image;
+    };
+
+    // Keyed by QImage::cacheKey, every copy of a cached image shares it.
+    typedef QCache<qint64, QSharedPointer<QSGTexture>> TextureCache;
+
+    QCache<QString, CachedImage> m_images;
+    QQueue<Request> m_queue;
+    QTimer m_idleTimer;
+
+    // Guards the textures, the render thread creates and invalidates them
+    // while the GUI thread sees windows go away.
+    QMutex m_mutex;
+    QHash<QQuickWindow *, TextureCache *> m_textures;
+};
+
+#endif
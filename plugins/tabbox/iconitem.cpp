@@ -0,0 +1,166 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "iconitem.h"
+#include "iconcache.h"
+
+#include <QQuickWindow>
+#include <QSGSimpleTextureNode>
+#include <QtMath>
+
+// Keeps the texture alive while it is on screen, IconCache may drop it
+// from its cache meanwhile.
+class IconNode : public QSGSimpleTextureNode
+{
+public:
+    IconNode()
+    {
+        setFiltering(QSGTexture::Linear);
+        setOwnsTexture(false);
+    }
+
+    void setIconTexture(const QSharedPointer<QSGTexture> &texture)
+    {
+        setTexture(texture.data());
+        m_texture = texture;
+    }
+
+private:
+    QSharedPointer<QSGTexture> m_texture;
+};
+
+IconItem::IconItem(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+
+    connect(IconCache::instance(), &IconCache::imageReady, this, [this] {
+        if (m_pending)
+            updateImage();
+    });
+}
+
+QVariant IconItem::source() const
+{
+    return m_source;
+}
+
+void IconItem::setSource(const QVariant &source)
+{
+    if (m_source == source)
+        return;
+
+    m_source = source;
+
+    if (source.canConvert<QIcon>())
+        m_icon = source.value<QIcon>();
+    else if (source.type() == QVariant::String)
+        m_icon = QIcon::fromTheme(source.toString());
+    else
+        m_icon = QIcon();
+
+    updateImage();
+    emit sourceChanged();
+}
+
+bool IconItem::active() const
+{
+    return m_active;
+}
+
+void IconItem::setActive(bool active)
+{
+    if (m_active == active)
+        return;
+
+    m_active = active;
+    updateImage();
+    emit activeChanged();
+}
+
+int IconItem::deviceSize() const
+{
+    const qreal dpr = window() ? window()->effectiveDevicePixelRatio() : 1.0;
+    return qCeil(qMin(width(), height()) * dpr);
+}
+
+void IconItem::updateImage()
+{
+    const int size = deviceSize();
+    const QImage image = IconCache::instance()->cachedImage(m_icon, size, m_active);
+
+    m_pending = image.isNull() && !m_icon.isNull() && size > 0;
+    if (m_pending) {
+        IconCache::instance()->request(m_icon, size, m_active);
+
+        // Until it arrives, the same icon in another size or state looks
+        // better than nothing, another icon does not.
+        if (m_imageIcon == m_icon.cacheKey())
+            return;
+    }
+
+    m_image = image;
+    m_imageIcon = image.isNull() ? 0 : m_icon.cacheKey();
+    update();
+}
+
+QSGNode *IconItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    const QSharedPointer<QSGTexture> texture = IconCache::instance()->texture(window(), m_image);
+    if (!texture) {
+        delete oldNode;
+        return nullptr;
+    }
+
+    IconNode *node = static_cast<IconNode *>(oldNode);
+    if (!node)
+        node = new IconNode;
+
+    // Keep the aspect ratio and center like QIconItem does.
+    const qreal dpr = window()->effectiveDevicePixelRatio();
+    const qreal size = qMin(width(), height());
+    const QSizeF textureSize = QSizeF(texture->textureSize()) / dpr;
+    const QSizeF scaled = textureSize.scaled(size, size, Qt::KeepAspectRatio);
+    const QRectF rect((width() - scaled.width()) / 2, (height() - scaled.height()) / 2,
+                      scaled.width(), scaled.height());
+
+    node->setIconTexture(texture);
+    node->setRect(rect);
+
+    return node;
+}
+
+void IconItem::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+
+    if (newGeometry.size() != oldGeometry.size())
+        updateImage();
+}
+
+void IconItem::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    QQuickItem::itemChange(change, value);
+
+    // Both change the size in device pixels.
+    if (change == ItemSceneChange || change == ItemDevicePixelRatioHasChanged)
+        updateImage();
+}
@@ -0,0 +1,67 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef ICONITEM_H
+#define ICONITEM_H
+
+#include <QQuickItem>
+#include <QIcon>
+#include <QImage>
+
+// Drop-in for QIconItem that takes its texture from IconCache. The icon is
+// looked up on the GUI thread, a miss is decoded there later and the item
+// repaints once it arrives, the render thread only uploads.
+class IconItem : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariant source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+
+public:
+    explicit IconItem(QQuickItem *parent = nullptr);
+
+    QVariant source() const;
+    void setSource(const QVariant &source);
+
+    bool active() const;
+    void setActive(bool active);
+
+signals:
+    void sourceChanged();
+    void activeChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+private:
+    int deviceSize() const;
+    void updateImage();
+
+    QVariant m_source;
+    QIcon m_icon;
+    bool m_active = false;
+
+    QImage m_image;
+    qint64 m_imageIcon = 0;
+    bool m_pending = false;
+};
+
+#endif
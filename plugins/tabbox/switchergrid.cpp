@@ -0,0 +1,150 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "switchergrid.h"
+
+#include <QtGlobal>
+#include <QtMath>
+
+static int ceilDiv(int a, int b)
+{
+    return (a + b - 1) / b;
+}
+
+SwitcherGrid::SwitcherGrid(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void SwitcherGrid::setCount(int count)
+{
+    if (m_count == count)
+        return;
+
+    m_count = count;
+    emit countChanged();
+    updateLayout();
+}
+
+void SwitcherGrid::setCellWidth(int cellWidth)
+{
+    if (m_cellWidth == cellWidth)
+        return;
+
+    m_cellWidth = cellWidth;
+    emit cellWidthChanged();
+    updateLayout();
+}
+
+void SwitcherGrid::setCellHeight(int cellHeight)
+{
+    if (m_cellHeight == cellHeight)
+        return;
+
+    m_cellHeight = cellHeight;
+    emit cellHeightChanged();
+    updateLayout();
+}
+
+void SwitcherGrid::setMaxWidth(int maxWidth)
+{
+    if (m_maxWidth == maxWidth)
+        return;
+
+    m_maxWidth = maxWidth;
+    emit maxWidthChanged();
+    updateLayout();
+}
+
+void SwitcherGrid::setMaxHeight(int maxHeight)
+{
+    if (m_maxHeight == maxHeight)
+        return;
+
+    m_maxHeight = maxHeight;
+    emit maxHeightChanged();
+    updateLayout();
+}
+
+int SwitcherGrid::width() const
+{
+    const int optimal = m_cellWidth * m_columns;
+    return qMin(qMax(m_cellWidth, optimal), m_maxWidth);
+}
+
+int SwitcherGrid::height() const
+{
+    const int optimal = m_cellHeight * m_rows;
+    return qMin(qMax(m_cellHeight, optimal), m_maxHeight);
+}
+
+QVariantList SwitcherGrid::iconSizes(int screenWidth, int screenHeight, qreal devicePixelRatio) const
+{
+    if (screenWidth <= 0 || screenHeight <= 0)
+        return {};
+
+    // Same arithmetic as the delegate: the thumbnail keeps the screen's
+    // aspect ratio, the icon sits in what the margins and caption leave.
+    const int thumbnailHeight = thumbnailWidth() * screenHeight / screenWidth;
+    const qreal area = qMax(0, thumbnailHeight - 2 * cellMargin() - cellSpacing());
+
+    return {
+        qCeil(area * badgeIconScale() * devicePixelRatio),
+        qCeil(area * placeholderIconScale() * devicePixelRatio),
+    };
+}
+
+void SwitcherGrid::updateLayout()
+{
+    int columns = 1;
+    int rows = 0;
+
+    if (m_count > 0 && m_cellWidth > 0 && m_cellHeight > 0) {
+        // The screen bounds the candidates, not the window count, so this
+        // costs the same with 5 windows or 500.
+        const int maxColumns = qMax(1, qMin(m_count, m_maxWidth / m_cellWidth));
+        const int maxRows = qMax(1, m_maxHeight / m_cellHeight);
+
+        columns = maxColumns;
+        int bestEmpty = maxColumns * ceilDiv(m_count, maxColumns) - m_count;
+
+        // Fewer columns only pay off while they fill the last row better,
+        // keep the grid landscape and fit in the maximum height.
+        for (int c = maxColumns - 1; c > 0 && bestEmpty > 0; --c) {
+            const int r = ceilDiv(m_count, c);
+            if (r > c || r > maxRows)
+                break;
+
+            const int empty = c * r - m_count;
+            if (empty < bestEmpty) {
+                bestEmpty = empty;
+                columns = c;
+            }
+        }
+
+        rows = ceilDiv(m_count, columns);
+    }
+
+    if (columns == m_columns && rows == m_rows)
+        return;
+
+    m_columns = columns;
+    m_rows = rows;
+    emit layoutChanged();
+}
@@ -0,0 +1,106 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef SWITCHERGRID_H
+#define SWITCHERGRID_H
+
+#include <QObject>
+#include <QVariantList>
+
+// Picks the switcher grid shape for a window count: as few empty cells as
+// possible, never taller than wide, within the maximum size.
+class SwitcherGrid : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count WRITE setCount NOTIFY countChanged)
+    Q_PROPERTY(int cellWidth READ cellWidth WRITE setCellWidth NOTIFY cellWidthChanged)
+    Q_PROPERTY(int cellHeight READ cellHeight WRITE setCellHeight NOTIFY cellHeightChanged)
+    Q_PROPERTY(int maxWidth READ maxWidth WRITE setMaxWidth NOTIFY maxWidthChanged)
+    Q_PROPERTY(int maxHeight READ maxHeight WRITE setMaxHeight NOTIFY maxHeightChanged)
+    Q_PROPERTY(int columns READ columns NOTIFY layoutChanged)
+    Q_PROPERTY(int rows READ rows NOTIFY layoutChanged)
+    Q_PROPERTY(int width READ width NOTIFY layoutChanged)
+    Q_PROPERTY(int height READ height NOTIFY layoutChanged)
+
+    // Cell metrics of cutefish_thumbnail, kept here so the prewarm script
+    // knows the icon sizes the switcher will ask for.
+    Q_PROPERTY(int thumbnailWidth READ thumbnailWidth CONSTANT)
+    Q_PROPERTY(int captionHeight READ captionHeight CONSTANT)
+    Q_PROPERTY(int cellMargin READ cellMargin CONSTANT)
+    Q_PROPERTY(int cellSpacing READ cellSpacing CONSTANT)
+    Q_PROPERTY(qreal badgeIconScale READ badgeIconScale CONSTANT)
+    Q_PROPERTY(qreal placeholderIconScale READ placeholderIconScale CONSTANT)
+
+public:
+    explicit SwitcherGrid(QObject *parent = nullptr);
+
+    // Icon sizes in device pixels, as IconItem computes them, for the
+    // switcher on a screen of that size: the badge over a ready thumbnail
+    // and the large icon shown until then.
+    Q_INVOKABLE QVariantList iconSizes(int screenWidth, int screenHeight, qreal devicePixelRatio) const;
+
+    int count() const { return m_count; }
+    void setCount(int count);
+
+    int cellWidth() const { return m_cellWidth; }
+    void setCellWidth(int cellWidth);
+
+    int cellHeight() const { return m_cellHeight; }
+    void setCellHeight(int cellHeight);
+
+    int maxWidth() const { return m_maxWidth; }
+    void setMaxWidth(int maxWidth);
+
+    int maxHeight() const { return m_maxHeight; }
+    void setMaxHeight(int maxHeight);
+
+    int columns() const { return m_columns; }
+    int rows() const { return m_rows; }
+    int width() const;
+    int height() const;
+
+    int thumbnailWidth() const { return 300; }
+    int captionHeight() const { return 22; }
+    int cellMargin() const { return 16; }
+    int cellSpacing() const { return 5; }
+    qreal badgeIconScale() const { return 0.3; }
+    qreal placeholderIconScale() const { return 0.6; }
+
+signals:
+    void countChanged();
+    void cellWidthChanged();
+    void cellHeightChanged();
+    void maxWidthChanged();
+    void maxHeightChanged();
+    void layoutChanged();
+
+private:
+    void updateLayout();
+
+    int m_count = 0;
+    int m_cellWidth = 0;
+    int m_cellHeight = 0;
+    int m_maxWidth = 0;
+    int m_maxHeight = 0;
+
+    int m_columns = 1;
+    int m_rows = 0;
+};
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "tabboxplugin.h"
+#include "iconcache.h"
+#include "iconitem.h"
+#include "switchergrid.h"
+
+#include <QQmlEngine>
+
+void TabBoxPlugin::registerTypes(const char *uri)
+{
+    Q_ASSERT(QLatin1String(uri) == QLatin1String("Cutefish.TabBox"));
+
+    qmlRegisterType<IconItem>(uri, 1, 0, "IconItem");
+    qmlRegisterType<SwitcherGrid>(uri, 1, 0, "SwitcherGrid");
+    qmlRegisterSingletonType<IconCache>(uri, 1, 0, "IconCache", [](QQmlEngine *, QJSEngine *) -> QObject * {
+        QObject *cache = IconCache::instance();
+        QQmlEngine::setObjectOwnership(cache, QQmlEngine::CppOwnership);
+        return cache;
+    });
+}
@@ -72,10 +72,21 @@ function isPopupWindow(window) {
     return false;
 }
 
+// Menus and combo box popups are opened by a click or a key press, they
+// are shown at full opacity on their first frame so the fade never adds
+// to the time until they can be read. They still fade out, that happens
+// after the choice was made. The roundedwindow effect measures the time
+// to the first opaque frame, see debug kwin4_effect_roundedwindow popups.
+function isInteractivePopup(window) {
+    return window.popupMenu || window.dropdownMenu || window.comboBox;
+}
+
 var cutefishPopupsEffect = {
     loadConfig: function () {
-        cutefishPopupsEffect.fadeInDuration = animationTime(100);
-        cutefishPopupsEffect.fadeOutDuration = animationTime(100) * 4;
+        // Handed on by the blur and roundedwindow effects, see lowpower.h.
+        var lowPower = effect.readConfig("LowPower", false);
+        cutefishPopupsEffect.fadeInDuration = lowPower ? 0 : animationTime(100);
+        cutefishPopupsEffect.fadeOutDuration = animationTime(100) * (lowPower ? 1 : 4);
     },
     slotWindowAdded: function (window) {
         if (effects.hasActiveFullScreenEffect) {
@@ -87,6 +98,9 @@ var cutefishPopupsEffect = {
         if (!window.visible) {
             return;
         }
+        if (!cutefishPopupsEffect.fadeInDuration || isInteractivePopup(window)) {
+            return;
+        }
         if (!effect.grab(window, Effect.WindowAddedGrabRole)) {
             return;
         }
@@ -27,11 +27,58 @@ var scaleEffect = {
     loadConfig: function (window) {
         var defaultDuration = 250;
         var duration = effect.readConfig("Duration", defaultDuration) || defaultDuration;
+        // Handed on by the blur and roundedwindow effects, see lowpower.h.
+        if (effect.readConfig("LowPower", false)) {
+            duration /= 2;
+        }
         scaleEffect.duration = animationTime(duration);
         scaleEffect.inScale = 0.96;
         scaleEffect.inOpacity = 1.0;
         scaleEffect.outScale = 0.96;
         scaleEffect.outOpacity = 0.0;
+
+        // More than burstCount windows mapped within burstInterval ms is a
+        // burst, e.g. a session being restored.
+        scaleEffect.burstCount = effect.readConfig("BurstCount", 5);
+        scaleEffect.burstInterval = effect.readConfig("BurstInterval", 1000);
+
+        // Area of closed windows kept alive for their animation, in screens.
+        scaleEffect.retainBudget = effect.readConfig("CloseRetainBudget", 1.0);
+    },
+    retainedArea: 0,
+    canRetain: function (window) {
+        var screen = effects.virtualScreenSize;
+        var budget = scaleEffect.retainBudget * screen.width * screen.height;
+        return scaleEffect.retainedArea + window.width * window.height <= budget;
+    },
+    retain: function (window) {
+        window.retainedArea = window.width * window.height;
+        scaleEffect.retainedArea += window.retainedArea;
+    },
+    release: function (window) {
+        if (window.retainedArea) {
+            scaleEffect.retainedArea -= window.retainedArea;
+            delete window.retainedArea;
+        }
+    },
+    recentlyAdded: [],
+    burstUntil: 0,
+    isBurst: function () {
+        var now = Date.now();
+        var recent = scaleEffect.recentlyAdded;
+
+        recent.push(now);
+        while (recent.length > 0 && now - recent[0] > scaleEffect.burstInterval) {
+            recent.shift();
+        }
+
+        // Stay in burst mode until windows stop arriving for a whole
+        // interval, then animate normally again.
+        if (recent.length > scaleEffect.burstCount) {
+            scaleEffect.burstUntil = now + scaleEffect.burstInterval;
+        }
+
+        return now < scaleEffect.burstUntil;
     },
     isScaleWindow: function (window) {
         // We don't want to animate most of plasmashell's windows, yet, some
@@ -89,6 +136,11 @@ var scaleEffect = {
         if (!window.visible) {
             return;
         }
+        // Dozens of animations at once only stutter, let the windows of a
+        // burst simply appear.
+        if (scaleEffect.isBurst()) {
+            return;
+        }
         if (!effect.grab(window, Effect.WindowAddedGrabRole)) {
             return;
         }
@@ -119,9 +171,15 @@ var scaleEffect = {
         if (!window.visible) {
             return;
         }
+        // Every animated closed window keeps its full texture until the
+        // animation ends. Past the budget, let KWin free it right away.
+        if (!scaleEffect.canRetain(window)) {
+            return;
+        }
         if (!effect.grab(window, Effect.WindowClosedGrabRole)) {
             return;
         }
+        scaleEffect.retain(window);
         if (window.scaleInAnimation) {
             cancel(window.scaleInAnimation);
             delete window.scaleInAnimation;
@@ -154,15 +212,20 @@ var scaleEffect = {
             if (window.scaleOutAnimation && effect.isGrabbed(window, role)) {
                 cancel(window.scaleOutAnimation);
                 delete window.scaleOutAnimation;
+                scaleEffect.release(window);
                 scaleEffect.cleanupForcedRoles(window);
             }
         }
     },
+    slotAnimationEnded: function (window) {
+        scaleEffect.release(window);
+        scaleEffect.cleanupForcedRoles(window);
+    },
     init: function () {
         scaleEffect.loadConfig();
 
         effect.configChanged.connect(scaleEffect.loadConfig);
-        effect.animationEnded.connect(scaleEffect.cleanupForcedRoles);
+        effect.animationEnded.connect(scaleEffect.slotAnimationEnded);
         effects.windowAdded.connect(scaleEffect.slotWindowAdded);
         effects.windowClosed.connect(scaleEffect.slotWindowClosed);
         effects.windowDataChanged.connect(scaleEffect.slotWindowDataChanged);
@@ -12,7 +12,9 @@
 var squashEffect = {
     duration: animationTime(300),
     loadConfig: function () {
-        squashEffect.duration = animationTime(300);
+        // Handed on by the blur and roundedwindow effects, see lowpower.h.
+        var lowPower = effect.readConfig("LowPower", false);
+        squashEffect.duration = animationTime(lowPower ? 150 : 300);
     },
     slotWindowMinimized: function (window) {
         if (effects.hasActiveFullScreenEffect) {
@@ -0,0 +1,85 @@
+import QtQuick 2.12
+import QtQuick.Window 2.12
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.12
+
+import org.kde.kquickcontrolsaddons 2.0
+import org.kde.kwin 2.0 as KWin
+
+import FishUI 1.0 as FishUI
+import Cutefish.TabBox 1.0 as CutefishTabBox
+
+// Declarative scripts share their QML engine with the window switcher, so
+// importing the same modules here loads their plugins and type data at
+// session start instead of on the first Alt+Tab. The switcher component is
+// compiled into the engine's cache as well, and the icons it shows are
+// decoded at idle into the shared IconCache.
+//
+// The switcher scene itself is not prebuilt: KWin creates and owns it on
+// the first Alt+Tab, an instance made here would be a second switcher that
+// KWin never shows.
+
+Item {
+    id: root
+
+    // Where CMakeLists.txt installs the switcher.
+    readonly property url switcherUrl: "file:///usr/share/kwin/tabbox/cutefish_thumbnail/contents/ui/main.qml"
+    // Held so the compilation is not collected halfway, never instantiated.
+    property Component switcher: null
+
+    // Gives the cell metrics of cutefish_thumbnail.
+    CutefishTabBox.SwitcherGrid {
+        id: grid
+    }
+
+    // The sizes IconItem will ask for, per screen the switcher may open on.
+    function iconSizes() {
+        var sizes = [];
+        var screens = Qt.application.screens;
+        for (var i = 0; i < screens.length; ++i) {
+            var screenSizes = grid.iconSizes(screens[i].width, screens[i].height, screens[i].devicePixelRatio);
+            for (var j = 0; j < screenSizes.length; ++j) {
+                if (sizes.indexOf(screenSizes[j]) == -1)
+                    sizes.push(screenSizes[j]);
+            }
+        }
+        return sizes;
+    }
+
+    function preload(client, sizes) {
+        if (!client || !client.icon)
+            return;
+
+        for (var i = 0; i < sizes.length; ++i) {
+            // The current item is drawn in the active state.
+            CutefishTabBox.IconCache.preload(client.icon, sizes[i], false);
+            CutefishTabBox.IconCache.preload(client.icon, sizes[i], true);
+        }
+    }
+
+    // Let the session finish starting before doing any work.
+    Timer {
+        interval: 3000
+        running: true
+        onTriggered: {
+            // Compiled off the GUI thread, only the cached type is kept.
+            root.switcher = Qt.createComponent(root.switcherUrl, Component.Asynchronous);
+            root.switcher.statusChanged.connect(function() {
+                if (root.switcher.status == Component.Error)
+                    console.warn("cutefish_tabbox_prewarm:", root.switcher.errorString());
+            });
+
+            var sizes = root.iconSizes();
+            var clients = workspace.clientList();
+            for (var i = 0; i < clients.length; ++i)
+                root.preload(clients[i], sizes);
+        }
+    }
+
+    Connections {
+        target: workspace
+        function onClientAdded(client) {
+            root.preload(client, root.iconSizes());
+        }
+    }
+}
@@ -1,24 +1,50 @@
-function forceFullScreen(client) {
-    var screen = client.screen;
-    var screenGeometry = workspace.clientArea(KWin.ScreenArea, screen, 0);
-    client.geometry = screenGeometry;
+// The launcher covers its whole screen, panels included, while staying in
+// the normal layer below them. A window rule cannot do both: full screen
+// moves it above the panels and a forced position and size is one fixed
+// geometry for every screen. The geometry is set when the launcher maps
+// and when screens change, never from its own geometryChanged, which
+// used to re-enter on every configure.
+var launchers = [];
+
+function isLauncher(client) {
+    return client.resourceClass == "cutefish-launcher"
+            && client.resourceName == "cutefish-launcher" && !client.dialog;
+}
+
+function forceScreenArea(client) {
+    var screenGeometry = workspace.clientArea(KWin.ScreenArea, client.screen, 0);
+    var geometry = client.geometry;
+    if (geometry.x != screenGeometry.x || geometry.y != screenGeometry.y
+            || geometry.width != screenGeometry.width || geometry.height != screenGeometry.height)
+        client.geometry = screenGeometry;
 }
 
 function setupConnection(client) {
-    if (client.resourceClass != "cutefish-launcher"
-            || client.resourceName != "cutefish-launcher" || client.dialog) {
+    if (!isLauncher(client))
         return;
-    }
 
-    forceFullScreen(client)
-    client.geometryChanged.connect(client, function () {
-        forceFullScreen(this);
+    launchers.push(client);
+    forceScreenArea(client);
+    client.screenChanged.connect(client, function () {
+        forceScreenArea(this);
     });
 }
 
+function forceAll() {
+    for (var i = 0; i < launchers.length; i++)
+        forceScreenArea(launchers[i]);
+}
+
 workspace.clientAdded.connect(setupConnection);
+workspace.clientRemoved.connect(function (client) {
+    var index = launchers.indexOf(client);
+    if (index != -1)
+        launchers.splice(index, 1);
+});
+workspace.virtualScreenGeometryChanged.connect(forceAll);
+
 // connect all existing clients
 var clients = workspace.clientList();
 for (var i = 0; i < clients.length; i++) {
     setupConnection(clients[i]);
-}
\ No newline at end of file
+}
@@ -9,6 +9,7 @@ import org.kde.kquickcontrolsaddons 2.0
 import org.kde.kwin 2.0 as KWin
 
 import FishUI 1.0 as FishUI
+import Cutefish.TabBox 1.0 as CutefishTabBox
 
 // https://techbase.kde.org/Development/Tutorials/KWin/WindowSwitcher
 
@@ -22,20 +23,21 @@ KWin.Switcher {
         flags: Qt.BypassWindowManagerHint | Qt.FramelessWindowHint
         color: "transparent"
 
-        property int maxWidth: tabBox.screenGeometry.width * 0.95
-        property int maxHeight: tabBox.screenGeometry.height * 0.7
-        property int optimalWidth: thumbnailGridView.cellWidth * gridColumns
-        property int optimalHeight: thumbnailGridView.cellHeight * gridRows
-        property int maxGridColumnsByWidth: Math.floor(maxWidth / thumbnailGridView.cellWidth)
-        property int gridColumns: maxGridColumnsByWidth
-        property int gridRows: Math.ceil(thumbnailGridView.count / gridColumns)
-
-        width: Math.min(Math.max(thumbnailGridView.cellWidth, optimalWidth), maxWidth)
-        height: Math.min(Math.max(thumbnailGridView.cellHeight, optimalHeight), maxHeight)
+        width: grid.width
+        height: grid.height
 
         x: tabBox.screenGeometry.x + (tabBox.screenGeometry.width - dialog.width) / 2
         y: tabBox.screenGeometry.y + (tabBox.screenGeometry.height - dialog.height) / 2
 
+        CutefishTabBox.SwitcherGrid {
+            id: grid
+            count: thumbnailGridView.count
+            cellWidth: thumbnailGridView.cellWidth
+            cellHeight: thumbnailGridView.cellHeight
+            maxWidth: tabBox.screenGeometry.width * 0.95
+            maxHeight: tabBox.screenGeometry.height * 0.7
+        }
+
         FishUI.WindowHelper {
             id: windowHelper
         }
@@ -64,69 +66,14 @@ KWin.Switcher {
             border.width: windowHelper.compositing ? 0 : 1
         }
 
-        onVisibleChanged: {
-            if (visible) {
-                dialogMainItem.calculateColumnCount();
-            } else {
-                thumbnailGridView.highCount = 0;
-            }
-        }
-
         Item {
             id: dialogMainItem
             anchors.fill: parent
 
             property real screenFactor: tabBox.screenGeometry.width / tabBox.screenGeometry.height
 
-            property bool canStretchX: false
-            property bool canStretchY: false
-
             clip: true
 
-            // simple greedy algorithm
-            function calculateColumnCount() {
-                // respect screenGeometry
-                var c = Math.min(thumbnailGridView.count, dialog.maxGridColumnsByWidth);
-
-                var residue = thumbnailGridView.count % c;
-                if (residue == 0) {
-                    dialog.gridColumns = c;
-                    return;
-                }
-
-                // start greedy recursion
-                dialog.gridColumns = columnCountRecursion(c, c, c - residue);
-            }
-
-            // step for greedy algorithm
-            function columnCountRecursion(prevC, prevBestC, prevDiff) {
-                var c = prevC - 1;
-
-                // don't increase vertical extent more than horizontal
-                // and don't exceed maxHeight
-                if (prevC * prevC <= thumbnailGridView.count + prevDiff ||
-                        dialog.maxHeight < Math.ceil(thumbnailGridView.count / c) * thumbnailGridView.cellHeight) {
-                    return prevBestC;
-                }
-                var residue = thumbnailGridView.count % c;
-                // halts algorithm at some point
-                if (residue == 0) {
-                    return c;
-                }
-                // empty slots
-                var diff = c - residue;
-
-                // compare it to previous count of empty slots
-                if (diff < prevDiff) {
-                    return columnCountRecursion(c, c, diff);
-                } else if (diff == prevDiff) {
-                    // when it's the same try again, we'll stop early enough thanks to the landscape mode condition
-                    return columnCountRecursion(c, prevBestC, diff);
-                }
-                // when we've found a local minimum choose this one (greedy)
-                return columnCountRecursion(c, prevBestC, diff);
-            }
-
             property bool mouseEnabled: false
             MouseArea {
                 id: mouseDetector
@@ -142,8 +89,8 @@ KWin.Switcher {
 
                 anchors.fill: parent
 
-                property int captionRowHeight: 22
-                property int thumbnailWidth: 300
+                property int captionRowHeight: grid.captionHeight
+                property int thumbnailWidth: grid.thumbnailWidth
                 property int thumbnailHeight: thumbnailWidth * (1.0 / dialogMainItem.screenFactor)
                 cellWidth: thumbnailWidth
                 cellHeight: captionRowHeight + thumbnailHeight
@@ -151,14 +98,8 @@ KWin.Switcher {
 
                 clip: true
 
-                // allow expansion on increasing count
-                property int highCount: 0
-                onCountChanged: {
-                    if (highCount != count) {
-                        dialogMainItem.calculateColumnCount();
-                        highCount = count;
-                    }
-                }
+                // Only cells in view get a delegate, and with it a thumbnail.
+                cacheBuffer: 0
 
                 delegate: Item {
                     property bool isCurrent: thumbnailGridView.currentIndex === index
@@ -180,25 +121,49 @@ KWin.Switcher {
                         thumbnailGridView.currentIndexChanged(thumbnailGridView.currentIndex);
                     }
 
+                    // Metrics from SwitcherGrid, the prewarm script preloads
+                    // the icon sizes they give.
                     ColumnLayout {
                         anchors.fill: parent
-                        anchors.margins: 16
-
-                        QIconItem {
-                            id: iconItem
-                            // source: model.icon
-                            icon: model.icon
-                            width: parent.height * 0.5
-                            height: parent.height * 0.5
-                            state: index == thumbnailGridView.currentIndex ? QIconItem.ActiveState : QIconItem.DefaultState
-                            Layout.alignment: Qt.AlignHCenter
+                        anchors.margins: grid.cellMargin
+                        spacing: grid.cellSpacing
+
+                        Item {
+                            Layout.fillWidth: true
+                            Layout.fillHeight: true
+
+                            // KWin renders the thumbnail through an offscreen texture of the
+                            // item's own size, so it never costs more than the cell.
+                            Loader {
+                                id: thumbnailLoader
+                                anchors.fill: parent
+                                active: dialog.visible
+                                asynchronous: true
+                                sourceComponent: KWin.ThumbnailItem {
+                                    wId: windowId
+                                }
+                            }
+
+                            // Decoded once per icon and size, shared across openings.
+                            CutefishTabBox.IconItem {
+                                id: iconItem
+                                source: model.icon
+                                width: parent.height * (thumbnailLoader.status == Loader.Ready ? grid.badgeIconScale : grid.placeholderIconScale)
+                                height: width
+                                anchors.horizontalCenter: parent.horizontalCenter
+                                anchors.verticalCenter: thumbnailLoader.status == Loader.Ready ? undefined : parent.verticalCenter
+                                anchors.bottom: thumbnailLoader.status == Loader.Ready ? parent.bottom : undefined
+                                active: index == thumbnailGridView.currentIndex
+                            }
                         }
 
                         Label {
                             text: model.caption
                             Layout.fillWidth: true
+                            Layout.preferredHeight: thumbnailGridView.captionRowHeight
                             elide: Text.ElideRight
                             horizontalAlignment: Text.AlignHCenter
+                            verticalAlignment: Text.AlignVCenter
                             color: isCurrent ? FishUI.Theme.highlightedTextColor : FishUI.Theme.textColor
                         }
                     }
@@ -0,0 +1,317 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "decorationfixture.h"
+#include "mockclient.h"
+#include "decoration.h"
+
+#include <KDecoration2/DecorationButton>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QHoverEvent>
+#include <QtTest>
+
+// Rendering a decoration is deterministic per platform, the tolerance only
+// absorbs antialiasing differences between Qt releases.
+static const int s_channelTolerance = 2;
+static const qreal s_pixelTolerance = 0.005;
+
+class DecorationBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void create_data();
+    void create();
+    void paintFull_data();
+    void paintFull();
+    void paintHover_data();
+    void paintHover();
+    void captionChange_data();
+    void captionChange();
+    void resize_data();
+    void resize();
+    void themeSwitch();
+
+    void golden_data();
+    void golden();
+
+private:
+    void addScaleRows();
+    void compareGolden(const QImage &image, const QString &name);
+
+    DecorationFixture m_fixture;
+};
+
+void DecorationBenchmark::initTestCase()
+{
+    QVERIFY(m_fixture.isValid());
+}
+
+// The theme PixelRatio scales the layout, the output scale only the
+// rasterisation, both are exercised.
+void DecorationBenchmark::addScaleRows()
+{
+    QTest::addColumn<qreal>("pixelRatio");
+    QTest::addColumn<qreal>("devicePixelRatio");
+
+    for (qreal scale : { 1.0, 1.5, 2.0 }) {
+        QTest::newRow(qPrintable(QStringLiteral("theme@%1").arg(scale))) << scale << 1.0;
+        QTest::newRow(qPrintable(QStringLiteral("device@%1").arg(scale))) << 1.0 << scale;
+    }
+}
+
+void DecorationBenchmark::create_data()
+{
+    addScaleRows();
+}
+
+void DecorationBenchmark::create()
+{
+    QFETCH(qreal, pixelRatio);
+
+    m_fixture.writeTheme(pixelRatio, false);
+
+    // One decoration stays alive so the benchmark measures what KWin pays
+    // per new window, not the first decoration's shared setup.
+    QScopedPointer<Cutefish::Decoration> first(m_fixture.create());
+
+    QBENCHMARK {
+        delete m_fixture.create();
+    }
+}
+
+void DecorationBenchmark::paintFull_data()
+{
+    addScaleRows();
+}
+
+void DecorationBenchmark::paintFull()
+{
+    QFETCH(qreal, pixelRatio);
+    QFETCH(qreal, devicePixelRatio);
+
+    m_fixture.writeTheme(pixelRatio, false);
+    QScopedPointer<Cutefish::Decoration> decoration(m_fixture.create());
+    m_fixture.client()->setCaption(QStringLiteral("Cutefish"));
+
+    QImage image = DecorationFixture::render(decoration.data(), devicePixelRatio);
+
+    QBENCHMARK {
+        DecorationFixture::paint(decoration.data(), &image, decoration->rect());
+    }
+}
+
+void DecorationBenchmark::paintHover_data()
+{
+    addScaleRows();
+}
+
+void DecorationBenchmark::paintHover()
+{
+    QFETCH(qreal, pixelRatio);
+    QFETCH(qreal, devicePixelRatio);
+
+    m_fixture.writeTheme(pixelRatio, false);
+    QScopedPointer<Cutefish::Decoration> decoration(m_fixture.create());
+
+    KDecoration2::DecorationButton *close = nullptr;
+    for (KDecoration2::DecorationButton *button : decoration->findChildren<KDecoration2::DecorationButton *>()) {
+        if (button->type() == KDecoration2::DecorationButtonType::Close)
+            close = button;
+    }
+    QVERIFY(close);
+    QVERIFY(close->isVisible());
+
+    const QRect region = close->geometry().toRect();
+    const QPointF inside = close->geometry().center();
+    const QPointF outside = decoration->titleBar().topLeft();
+    QImage image = DecorationFixture::render(decoration.data(), devicePixelRatio);
+
+    // What KWin repaints while the pointer moves over a button.
+    bool hovered = false;
+    QBENCHMARK {
+        QHoverEvent event(QEvent::HoverMove, hovered ? outside : inside, hovered ? inside : outside);
+        QCoreApplication::sendEvent(decoration.data(), &event);
+        hovered = !hovered;
+
+        DecorationFixture::paint(decoration.data(), &image, region);
+    }
+}
+
+void DecorationBenchmark::captionChange_data()
+{
+    addScaleRows();
+}
+
+void DecorationBenchmark::captionChange()
+{
+    QFETCH(qreal, pixelRatio);
+    QFETCH(qreal, devicePixelRatio);
+
+    m_fixture.writeTheme(pixelRatio, false);
+    QScopedPointer<Cutefish::Decoration> decoration(m_fixture.create());
+    MockClient *client = m_fixture.client();
+
+    QImage image = DecorationFixture::render(decoration.data(), devicePixelRatio);
+
+    int i = 0;
+    QBENCHMARK {
+        client->setCaption(QStringLiteral("Document %1 - Cutefish").arg(i++));
+        DecorationFixture::paint(decoration.data(), &image, decoration->titleBar());
+    }
+}
+
+void DecorationBenchmark::resize_data()
+{
+    addScaleRows();
+}
+
+void DecorationBenchmark::resize()
+{
+    QFETCH(qreal, pixelRatio);
+    QFETCH(qreal, devicePixelRatio);
+
+    m_fixture.writeTheme(pixelRatio, false);
+    QScopedPointer<Cutefish::Decoration> decoration(m_fixture.create());
+    MockClient *client = m_fixture.client();
+    client->setCaption(QStringLiteral("Cutefish"));
+
+    // An interactive resize, one step per frame.
+    QBENCHMARK {
+        for (int width = 400; width <= 1200; width += 40) {
+            client->setSize(QSize(width, 600));
+            DecorationFixture::render(decoration.data(), devicePixelRatio);
+        }
+    }
+}
+
+void DecorationBenchmark::themeSwitch()
+{
+    m_fixture.writeTheme(1.0, false);
+    QScopedPointer<Cutefish::Decoration> decoration(m_fixture.create());
+    QVERIFY(!decoration->darkMode());
+
+    // The watcher delivers the change from the event loop, this measures
+    // the whole hand-off from the settings write to the new palette.
+    bool dark = false;
+    QBENCHMARK {
+        dark = !dark;
+        m_fixture.writeTheme(1.0, dark);
+        QTRY_COMPARE(decoration->darkMode(), dark);
+        DecorationFixture::render(decoration.data(), 1.0);
+    }
+}
+
+void DecorationBenchmark::golden_data()
+{
+    QTest::addColumn<qreal>("pixelRatio");
+    QTest::addColumn<qreal>("devicePixelRatio");
+    QTest::addColumn<bool>("darkMode");
+    QTest::addColumn<bool>("active");
+    QTest::addColumn<bool>("maximized");
+
+    for (qreal scale : { 1.0, 1.5, 2.0 }) {
+        for (bool darkMode : { false, true }) {
+            for (bool active : { true, false }) {
+                const QString name = QStringLiteral("%1-%2-%3")
+                        .arg(scale)
+                        .arg(darkMode ? "dark" : "light")
+                        .arg(active ? "active" : "inactive");
+                QTest::newRow(qPrintable(QStringLiteral("theme@") + name)) << scale << 1.0 << darkMode << active << false;
+                QTest::newRow(qPrintable(QStringLiteral("device@") + name)) << 1.0 << scale << darkMode << active << false;
+            }
+        }
+
+        QTest::newRow(qPrintable(QStringLiteral("theme@%1-light-maximized").arg(scale))) << scale << 1.0 << false << true << true;
+    }
+}
+
+void DecorationBenchmark::golden()
+{
+    QFETCH(qreal, pixelRatio);
+    QFETCH(qreal, devicePixelRatio);
+    QFETCH(bool, darkMode);
+    QFETCH(bool, active);
+    QFETCH(bool, maximized);
+
+    m_fixture.writeTheme(pixelRatio, darkMode);
+    QScopedPointer<Cutefish::Decoration> decoration(m_fixture.create());
+    MockClient *client = m_fixture.client();
+
+    // No caption, text rendering depends on the fonts installed.
+    client->setCaption(QString());
+    client->setActive(active);
+    client->setMaximized(maximized);
+
+    compareGolden(DecorationFixture::render(decoration.data(), devicePixelRatio),
+                  QString::fromLatin1(QTest::currentDataTag()).replace('@', '-') + ".png");
+}
+
+void DecorationBenchmark::compareGolden(const QImage &image, const QString &name)
+{
+    const QString goldenPath = QDir(GOLDEN_DIR).filePath(name);
+
+    if (qEnvironmentVariableIsSet("CUTEFISH_UPDATE_GOLDEN")) {
+        QVERIFY(image.save(goldenPath));
+        return;
+    }
+
+    const QImage golden = QImage(goldenPath).convertToFormat(image.format());
+
+    if (golden.isNull()) {
+        const QDir candidates(QCoreApplication::applicationDirPath() + "/golden-candidates");
+        QVERIFY(candidates.mkpath("."));
+        QVERIFY(image.save(candidates.filePath(name)));
+        QFAIL(qPrintable(QStringLiteral("No golden image %1, wrote a candidate to %2, run with CUTEFISH_UPDATE_GOLDEN=1 to accept it")
+                         .arg(name, candidates.path())));
+    }
+
+    QCOMPARE(image.size(), golden.size());
+
+    int differing = 0;
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *actual = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        const QRgb *expected = reinterpret_cast<const QRgb *>(golden.constScanLine(y));
+
+        for (int x = 0; x < image.width(); ++x) {
+            if (qAbs(qRed(actual[x]) - qRed(expected[x])) > s_channelTolerance
+                    || qAbs(qGreen(actual[x]) - qGreen(expected[x])) > s_channelTolerance
+                    || qAbs(qBlue(actual[x]) - qBlue(expected[x])) > s_channelTolerance
+                    || qAbs(qAlpha(actual[x]) - qAlpha(expected[x])) > s_channelTolerance)
+                ++differing;
+        }
+    }
+
+    const int allowed = image.width() * image.height() * s_pixelTolerance;
+    if (differing > allowed) {
+        const QDir failures(QCoreApplication::applicationDirPath() + "/golden-failures");
+        failures.mkpath(".");
+        image.save(failures.filePath(name));
+        QFAIL(qPrintable(QStringLiteral("%1 differs from the golden in %2 pixels, %3 allowed, the rendering was written to %4")
+                         .arg(name).arg(differing).arg(allowed).arg(failures.path())));
+    }
+}
+
+QTEST_MAIN(DecorationBenchmark)
+
+#include "decorationbenchmark.moc"
@@ -0,0 +1,86 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "decorationfixture.h"
+#include "mockclient.h"
+#include "decoration.h"
+
+#include <KDecoration2/DecorationSettings>
+
+#include <QPainter>
+#include <QSettings>
+#include <QStandardPaths>
+
+DecorationFixture::DecorationFixture()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+
+    m_settings = QSharedPointer<KDecoration2::DecorationSettings>::create(&m_bridge);
+}
+
+DecorationFixture::~DecorationFixture()
+{
+    m_settings.clear();
+}
+
+bool DecorationFixture::isValid() const
+{
+    return m_dir.isValid();
+}
+
+void DecorationFixture::writeTheme(qreal pixelRatio, bool darkMode)
+{
+    QSettings settings(QSettings::UserScope, "cutefishos", "theme");
+    settings.setValue("PixelRatio", pixelRatio);
+    settings.setValue("DarkMode", darkMode);
+    settings.sync();
+}
+
+Cutefish::Decoration *DecorationFixture::create()
+{
+    Cutefish::Decoration *decoration = new Cutefish::Decoration(nullptr, m_bridge.decorationArgs());
+    decoration->setSettings(m_settings);
+    decoration->init();
+    return decoration;
+}
+
+MockClient *DecorationFixture::client() const
+{
+    return m_bridge.lastCreatedClient();
+}
+
+QImage DecorationFixture::render(Cutefish::Decoration *decoration, qreal devicePixelRatio)
+{
+    const QRect rect = decoration->rect();
+
+    QImage image(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::transparent);
+
+    paint(decoration, &image, rect);
+    return image;
+}
+
+void DecorationFixture::paint(Cutefish::Decoration *decoration, QImage *image, const QRect &region)
+{
+    QPainter painter(image);
+    painter.setClipRect(region);
+    decoration->paint(&painter, region);
+}
@@ -0,0 +1,67 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DECORATIONFIXTURE_H
+#define DECORATIONFIXTURE_H
+
+#include "mockbridge.h"
+
+#include <QImage>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+
+class MockClient;
+
+namespace KDecoration2
+{
+class DecorationSettings;
+}
+
+namespace Cutefish
+{
+class Decoration;
+}
+
+// Runs the decoration the way KWin does, against a theme file in a
+// temporary directory instead of the user's.
+class DecorationFixture
+{
+public:
+    DecorationFixture();
+    ~DecorationFixture();
+
+    bool isValid() const;
+
+    // Written where the decoration reads ~/.config/cutefishos/theme.conf.
+    void writeTheme(qreal pixelRatio, bool darkMode);
+
+    Cutefish::Decoration *create();
+    MockClient *client() const;
+
+    // The decoration painted into an image of the given device pixel ratio.
+    static QImage render(Cutefish::Decoration *decoration, qreal devicePixelRatio);
+    static void paint(Cutefish::Decoration *decoration, QImage *image, const QRect &region);
+
+private:
+    QTemporaryDir m_dir;
+    MockBridge m_bridge;
+    QSharedPointer<KDecoration2::DecorationSettings> m_settings;
+};
+
+#endif
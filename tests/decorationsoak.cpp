@@ -0,0 +1,173 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "decorationfixture.h"
+#include "memoryaccounting.h"
+#include "mockclient.h"
+#include "decoration.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtTest>
+
+#include <unistd.h>
+
+// Enough cycles for a leak of a few bytes per decoration to show over the
+// allocator's noise.
+static const int s_cycles = 5000;
+static const int s_warmupCycles = 200;
+static const qint64 s_rssSlack = 4 * 1024 * 1024;
+
+struct ProcessUsage {
+    qint64 rss = 0;
+    int fds = 0;
+    int inotifyWatches = 0;
+};
+
+static ProcessUsage processUsage()
+{
+    ProcessUsage usage;
+
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1)
+            usage.rss = fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+
+    const QDir fdinfo(QStringLiteral("/proc/self/fdinfo"));
+    for (const QString &fd : fdinfo.entryList(QDir::Files)) {
+        ++usage.fds;
+
+        QFile info(fdinfo.filePath(fd));
+        if (!info.open(QIODevice::ReadOnly))
+            continue;
+
+        for (const QByteArray &line : info.readAll().split('\n')) {
+            if (line.startsWith("inotify wd:"))
+                ++usage.inotifyWatches;
+        }
+    }
+
+    return usage;
+}
+
+// Creates, uses and destroys decorations the way opening and closing
+// windows does, and checks the process does not grow with it. The effect
+// side, textures and shaders per EffectWindow, needs a running KWin and
+// is not covered here.
+class DecorationSoak : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void cycle_data();
+    void cycle();
+
+private:
+    void runCycle(qreal devicePixelRatio, int i);
+
+    DecorationFixture m_fixture;
+};
+
+void DecorationSoak::initTestCase()
+{
+    QVERIFY(m_fixture.isValid());
+    m_fixture.writeTheme(1.0, false);
+}
+
+void DecorationSoak::cycle_data()
+{
+    QTest::addColumn<bool>("persistent");
+
+    // With one window kept open the shared theme watcher stays, without
+    // it every cycle tears down and recreates it.
+    QTest::newRow("with-persistent") << true;
+    QTest::newRow("without-persistent") << false;
+}
+
+void DecorationSoak::runCycle(qreal devicePixelRatio, int i)
+{
+    QScopedPointer<Cutefish::Decoration> decoration(m_fixture.create());
+    MockClient *client = m_fixture.client();
+
+    client->setCaption(QStringLiteral("Window %1").arg(i));
+    client->setSize(QSize(400 + i % 400, 300));
+    DecorationFixture::render(decoration.data(), devicePixelRatio);
+    client->setMaximized(true);
+    DecorationFixture::render(decoration.data(), devicePixelRatio);
+}
+
+void DecorationSoak::cycle()
+{
+    QFETCH(bool, persistent);
+
+    QScopedPointer<Cutefish::Decoration> kept;
+    if (persistent) {
+        kept.reset(m_fixture.create());
+        DecorationFixture::render(kept.data(), 1.0);
+    }
+
+    // Lets the allocator and the shared caches reach their steady state.
+    for (int i = 0; i < s_warmupCycles; ++i)
+        runCycle(i % 2 ? 2.0 : 1.0, i);
+    QCoreApplication::processEvents();
+
+    const ProcessUsage before = processUsage();
+    const int pixmapsBefore = Cutefish::Memory::count("decoration/button-pixmaps", Cutefish::Memory::Cpu);
+    const qint64 pixmapBytesBefore = Cutefish::Memory::bytes("decoration/button-pixmaps", Cutefish::Memory::Cpu);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < s_cycles; ++i) {
+        runCycle(i % 2 ? 2.0 : 1.0, i);
+
+        if (i % 100 == 0)
+            QCoreApplication::processEvents();
+    }
+    QCoreApplication::processEvents();
+
+    const qint64 elapsed = timer.nsecsElapsed();
+    const ProcessUsage after = processUsage();
+
+    qInfo("%d cycles, %.1f us per cycle, rss %+lld bytes, %+.1f bytes per cycle, fds %d -> %d, inotify watches %d -> %d",
+          s_cycles, elapsed / 1000.0 / s_cycles,
+          after.rss - before.rss, qreal(after.rss - before.rss) / s_cycles,
+          before.fds, after.fds, before.inotifyWatches, after.inotifyWatches);
+
+    QCOMPARE(after.fds, before.fds);
+    QCOMPARE(after.inotifyWatches, before.inotifyWatches);
+    QVERIFY2(after.rss - before.rss < s_rssSlack,
+             qPrintable(QStringLiteral("rss grew by %1 bytes").arg(after.rss - before.rss)));
+
+    QCOMPARE(Cutefish::Memory::count("decoration/button-pixmaps", Cutefish::Memory::Cpu), pixmapsBefore);
+    QCOMPARE(Cutefish::Memory::bytes("decoration/button-pixmaps", Cutefish::Memory::Cpu), pixmapBytesBefore);
+
+    kept.reset();
+    QCOMPARE(Cutefish::Memory::count("decoration/button-pixmaps", Cutefish::Memory::Cpu), 0);
+    QCOMPARE(Cutefish::Memory::bytes("decoration/shadow", Cutefish::Memory::Cpu), qint64(0));
+}
+
+QTEST_MAIN(DecorationSoak)
+
+#include "decorationsoak.moc"
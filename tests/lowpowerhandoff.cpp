@@ -0,0 +1,230 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "lowpowerfile.h"
+#include "powerprofile.h"
+
+#include <QDBusAbstractAdaptor>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <KConfigGroup>
+#include <KConfigLoader>
+#include <KSharedConfig>
+
+static const QString s_service = QStringLiteral("net.hadess.PowerProfiles");
+static const QString s_path = QStringLiteral("/net/hadess/PowerProfiles");
+
+// Stands in for power-profiles-daemon, on its own connection so the
+// client side talks to it over the bus like to the real one.
+class MockPowerProfiles : public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "net.hadess.PowerProfiles")
+    Q_PROPERTY(QString ActiveProfile READ activeProfile)
+
+public:
+    explicit MockPowerProfiles(QObject *parent)
+        : QDBusAbstractAdaptor(parent)
+        , m_bus(QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("mock-power-profiles")))
+    {
+    }
+
+    ~MockPowerProfiles() override
+    {
+        stop();
+        QDBusConnection::disconnectFromBus(m_bus.name());
+    }
+
+    QString activeProfile() const
+    {
+        return m_profile;
+    }
+
+    bool start(const QString &profile)
+    {
+        m_profile = profile;
+        return m_bus.registerObject(s_path, parent(), QDBusConnection::ExportAdaptors)
+            && m_bus.registerService(s_service);
+    }
+
+    void stop()
+    {
+        m_bus.unregisterService(s_service);
+        m_bus.unregisterObject(s_path);
+    }
+
+    // What the daemon does on `powerprofilesctl set`.
+    void setProfile(const QString &profile)
+    {
+        m_profile = profile;
+
+        QDBusMessage message = QDBusMessage::createSignal(s_path, QStringLiteral("org.freedesktop.DBus.Properties"),
+                                                          QStringLiteral("PropertiesChanged"));
+        message << s_service << QVariantMap { { QStringLiteral("ActiveProfile"), profile } } << QStringList();
+        m_bus.send(message);
+    }
+
+private:
+    QDBusConnection m_bus;
+    QString m_profile;
+};
+
+// Follows a power profile change from the daemon to what a scripted
+// effect reads, the way the effects hand it off. Runs on a private
+// session bus, see CMakeLists.txt.
+class LowPowerHandOff : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void followsTheDaemon();
+    void daemonStartsLater();
+    void daemonGoesAway();
+    void scriptedEffectSeesIt();
+
+private:
+    QTemporaryDir m_runtimeDir;
+    QObject *m_daemonObject = nullptr;
+    MockPowerProfiles *m_daemon = nullptr;
+};
+
+void LowPowerHandOff::initTestCase()
+{
+    QVERIFY(QDBusConnection::sessionBus().isConnected());
+
+    // Where LowPowerFile writes, 0700 like the real one.
+    QVERIFY(m_runtimeDir.isValid());
+    qputenv("XDG_RUNTIME_DIR", QFile::encodeName(m_runtimeDir.path()));
+    QCOMPARE(Cutefish::LowPowerFile::path(), m_runtimeDir.filePath(QStringLiteral("cutefish-lowpowerrc")));
+}
+
+void LowPowerHandOff::init()
+{
+    m_daemonObject = new QObject;
+    m_daemon = new MockPowerProfiles(m_daemonObject);
+}
+
+void LowPowerHandOff::cleanup()
+{
+    delete m_daemonObject;
+    m_daemonObject = nullptr;
+    m_daemon = nullptr;
+}
+
+void LowPowerHandOff::followsTheDaemon()
+{
+    QVERIFY(m_daemon->start(QStringLiteral("balanced")));
+
+    Cutefish::PowerProfile profile(QDBusConnection::sessionBus());
+    QTRY_COMPARE(profile.profile(), QStringLiteral("balanced"));
+    QVERIFY(!profile.isLowPower());
+
+    QSignalSpy changed(&profile, &Cutefish::PowerProfile::changed);
+    m_daemon->setProfile(QStringLiteral("power-saver"));
+    QTRY_COMPARE(changed.count(), 1);
+    QVERIFY(profile.isLowPower());
+
+    // Not a low power change.
+    m_daemon->setProfile(QStringLiteral("power-saver"));
+    m_daemon->setProfile(QStringLiteral("balanced"));
+    QTRY_COMPARE(changed.count(), 2);
+    QVERIFY(!profile.isLowPower());
+}
+
+void LowPowerHandOff::daemonStartsLater()
+{
+    Cutefish::PowerProfile profile(QDBusConnection::sessionBus());
+    QTest::qWait(100);
+    QVERIFY(profile.profile().isEmpty());
+
+    QSignalSpy changed(&profile, &Cutefish::PowerProfile::changed);
+    QVERIFY(m_daemon->start(QStringLiteral("power-saver")));
+    QTRY_COMPARE(changed.count(), 1);
+    QVERIFY(profile.isLowPower());
+}
+
+void LowPowerHandOff::daemonGoesAway()
+{
+    QVERIFY(m_daemon->start(QStringLiteral("power-saver")));
+
+    Cutefish::PowerProfile profile(QDBusConnection::sessionBus());
+    QTRY_VERIFY(profile.isLowPower());
+
+    m_daemon->stop();
+    QTRY_VERIFY(profile.profile().isEmpty());
+    QVERIFY(!profile.isLowPower());
+}
+
+void LowPowerHandOff::scriptedEffectSeesIt()
+{
+    const QString effect = QStringLiteral("cutefish_scale");
+    const QString kwinrc = m_runtimeDir.filePath(QStringLiteral("kwinrc"));
+
+    // KWin's main kwinrc instance, and the loader ScriptedEffect builds
+    // on it from the effect's main.xml.
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(kwinrc);
+    QFile xml(QStringLiteral(SCRIPTS_DIR "/cutefish_scale/contents/config/main.xml"));
+    QVERIFY(xml.open(QIODevice::ReadOnly));
+    KConfigLoader loader(config->group(QStringLiteral("Effect-") + effect), &xml);
+    KConfigSkeletonItem *lowPower = loader.findItemByName(QStringLiteral("LowPower"));
+    QVERIFY(lowPower);
+    QCOMPARE(lowPower->property().toBool(), false);
+
+    QVERIFY(m_daemon->start(QStringLiteral("balanced")));
+    Cutefish::PowerProfile profile(QDBusConnection::sessionBus());
+    QTRY_COMPARE(profile.profile(), QStringLiteral("balanced"));
+
+    // What handOffLowPower() does, reconfigureEffect() ends in read().
+    QStringList reconfigured;
+    connect(&profile, &Cutefish::PowerProfile::changed, this, [&] {
+        reconfigured << Cutefish::LowPowerFile::publish(config, profile.isLowPower(), { effect });
+        loader.read();
+    });
+
+    m_daemon->setProfile(QStringLiteral("power-saver"));
+    QTRY_COMPARE(reconfigured, QStringList { effect });
+    QCOMPARE(lowPower->property().toBool(), true);
+
+    // KWin reparses kwinrc on every reconfigure, the state stays.
+    config->reparseConfiguration();
+    loader.read();
+    QCOMPARE(lowPower->property().toBool(), true);
+
+    m_daemon->setProfile(QStringLiteral("balanced"));
+    QTRY_COMPARE(reconfigured.count(), 2);
+    QCOMPARE(lowPower->property().toBool(), false);
+
+    // Nothing of it reaches the user's kwinrc.
+    QVERIFY(config->sync());
+    QFile file(kwinrc);
+    if (file.open(QIODevice::ReadOnly))
+        QVERIFY(!file.readAll().contains("LowPower"));
+}
+
+QTEST_GUILESS_MAIN(LowPowerHandOff)
+
+#include "lowpowerhandoff.moc"
@@ -0,0 +1,53 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "mockbridge.h"
+#include "mockclient.h"
+#include "mocksettings.h"
+
+#include <QVariantMap>
+
+std::unique_ptr<KDecoration2::DecoratedClientPrivate> MockBridge::createClient(KDecoration2::DecoratedClient *client,
+                                                                               KDecoration2::Decoration *decoration)
+{
+    auto mock = std::unique_ptr<MockClient>(new MockClient(client, decoration));
+    m_lastCreatedClient = mock.get();
+    return std::unique_ptr<KDecoration2::DecoratedClientPrivate>(mock.release());
+}
+
+std::unique_ptr<KDecoration2::DecorationSettingsPrivate> MockBridge::settings(KDecoration2::DecorationSettings *parent)
+{
+    return std::unique_ptr<KDecoration2::DecorationSettingsPrivate>(new MockSettings(parent));
+}
+
+void MockBridge::update(KDecoration2::Decoration *decoration, const QRect &geometry)
+{
+    Q_UNUSED(decoration)
+    Q_UNUSED(geometry)
+}
+
+QVariantList MockBridge::decorationArgs()
+{
+    return { QVariantMap({ { QStringLiteral("bridge"), QVariant::fromValue(static_cast<KDecoration2::DecorationBridge *>(this)) } }) };
+}
+
+MockClient *MockBridge::lastCreatedClient() const
+{
+    return m_lastCreatedClient;
+}
@@ -0,0 +1,56 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MOCKBRIDGE_H
+#define MOCKBRIDGE_H
+
+#include <KDecoration2/Private/DecorationBridge>
+
+#include <QPointer>
+
+class MockClient;
+
+namespace KDecoration2
+{
+class Decoration;
+}
+
+// What KWin provides to a decoration plugin, enough to run one headless.
+class MockBridge : public KDecoration2::DecorationBridge
+{
+    Q_OBJECT
+
+public:
+    std::unique_ptr<KDecoration2::DecoratedClientPrivate> createClient(KDecoration2::DecoratedClient *client,
+                                                                       KDecoration2::Decoration *decoration) override;
+    std::unique_ptr<KDecoration2::DecorationSettingsPrivate> settings(KDecoration2::DecorationSettings *parent) override;
+
+    // Older KDecoration2 releases have the bridge schedule repaints.
+    void update(KDecoration2::Decoration *decoration, const QRect &geometry);
+
+    // The arguments a plugin factory gets, pointing the decoration here.
+    QVariantList decorationArgs();
+
+    MockClient *lastCreatedClient() const;
+
+private:
+    QPointer<MockClient> m_lastCreatedClient;
+};
+
+#endif
@@ -0,0 +1,270 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "mockclient.h"
+
+#include <KDecoration2/DecoratedClient>
+
+#include <QIcon>
+#include <QPalette>
+
+MockClient::MockClient(KDecoration2::DecoratedClient *client, KDecoration2::Decoration *decoration)
+    : QObject()
+    , KDecoration2::DecoratedClientPrivate(client, decoration)
+{
+}
+
+bool MockClient::isActive() const
+{
+    return m_active;
+}
+
+QString MockClient::caption() const
+{
+    return m_caption;
+}
+
+int MockClient::desktop() const
+{
+    return 1;
+}
+
+bool MockClient::isOnAllDesktops() const
+{
+    return false;
+}
+
+bool MockClient::isShaded() const
+{
+    return false;
+}
+
+QIcon MockClient::icon() const
+{
+    return QIcon();
+}
+
+bool MockClient::isMaximized() const
+{
+    return m_maximized;
+}
+
+bool MockClient::isMaximizedHorizontally() const
+{
+    return m_maximized;
+}
+
+bool MockClient::isMaximizedVertically() const
+{
+    return m_maximized;
+}
+
+bool MockClient::isKeepAbove() const
+{
+    return false;
+}
+
+bool MockClient::isKeepBelow() const
+{
+    return false;
+}
+
+bool MockClient::isCloseable() const
+{
+    return true;
+}
+
+bool MockClient::isMaximizeable() const
+{
+    return true;
+}
+
+bool MockClient::isMinimizeable() const
+{
+    return true;
+}
+
+bool MockClient::providesContextHelp() const
+{
+    return false;
+}
+
+bool MockClient::isModal() const
+{
+    return false;
+}
+
+bool MockClient::isShadeable() const
+{
+    return false;
+}
+
+bool MockClient::isMoveable() const
+{
+    return true;
+}
+
+bool MockClient::isResizeable() const
+{
+    return true;
+}
+
+WId MockClient::windowId() const
+{
+    return 0;
+}
+
+WId MockClient::decorationId() const
+{
+    return 0;
+}
+
+int MockClient::width() const
+{
+    return m_size.width();
+}
+
+int MockClient::height() const
+{
+    return m_size.height();
+}
+
+QSize MockClient::size() const
+{
+    return m_size;
+}
+
+QPalette MockClient::palette() const
+{
+    return QPalette();
+}
+
+Qt::Edges MockClient::adjacentScreenEdges() const
+{
+    return m_edges;
+}
+
+QString MockClient::windowClass() const
+{
+    return QStringLiteral("cutefish-test cutefish-test");
+}
+
+void MockClient::requestShowToolTip(const QString &text)
+{
+    Q_UNUSED(text)
+}
+
+void MockClient::requestHideToolTip()
+{
+}
+
+void MockClient::requestClose()
+{
+}
+
+void MockClient::requestToggleMaximization(Qt::MouseButtons buttons)
+{
+    Q_UNUSED(buttons)
+    setMaximized(!m_maximized);
+}
+
+void MockClient::requestMinimize()
+{
+}
+
+void MockClient::requestContextHelp()
+{
+}
+
+void MockClient::requestToggleOnAllDesktops()
+{
+}
+
+void MockClient::requestToggleShade()
+{
+}
+
+void MockClient::requestToggleKeepAbove()
+{
+}
+
+void MockClient::requestToggleKeepBelow()
+{
+}
+
+void MockClient::requestShowWindowMenu()
+{
+}
+
+void MockClient::requestShowWindowMenu(const QRect &rect)
+{
+    Q_UNUSED(rect)
+}
+
+void MockClient::setActive(bool active)
+{
+    if (m_active == active)
+        return;
+
+    m_active = active;
+    emit client()->activeChanged(m_active);
+}
+
+void MockClient::setCaption(const QString &caption)
+{
+    if (m_caption == caption)
+        return;
+
+    m_caption = caption;
+    emit client()->captionChanged(m_caption);
+}
+
+void MockClient::setMaximized(bool maximized)
+{
+    if (m_maximized == maximized)
+        return;
+
+    m_maximized = maximized;
+    emit client()->maximizedHorizontallyChanged(m_maximized);
+    emit client()->maximizedVerticallyChanged(m_maximized);
+    emit client()->maximizedChanged(m_maximized);
+}
+
+void MockClient::setSize(const QSize &size)
+{
+    if (m_size == size)
+        return;
+
+    const QSize old = m_size;
+    m_size = size;
+    if (old.width() != size.width())
+        emit client()->widthChanged(size.width());
+    if (old.height() != size.height())
+        emit client()->heightChanged(size.height());
+    emit client()->sizeChanged(size);
+}
+
+void MockClient::setAdjacentScreenEdges(Qt::Edges edges)
+{
+    if (m_edges == edges)
+        return;
+
+    m_edges = edges;
+    emit client()->adjacentScreenEdgesChanged(m_edges);
+}
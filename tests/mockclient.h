@@ -0,0 +1,99 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MOCKCLIENT_H
+#define MOCKCLIENT_H
+
+#include <KDecoration2/Private/DecoratedClientPrivate>
+
+#include <QObject>
+
+// Stands in for the client KWin would wrap. The setters emit the same
+// DecoratedClient signals KWin does, so the decoration reacts as it would
+// in a session.
+class MockClient : public QObject, public KDecoration2::DecoratedClientPrivate
+{
+    Q_OBJECT
+
+public:
+    MockClient(KDecoration2::DecoratedClient *client, KDecoration2::Decoration *decoration);
+
+    bool isActive() const override;
+    QString caption() const override;
+    int desktop() const override;
+    bool isOnAllDesktops() const override;
+    bool isShaded() const override;
+    QIcon icon() const override;
+    bool isMaximized() const override;
+    bool isMaximizedHorizontally() const override;
+    bool isMaximizedVertically() const override;
+    bool isKeepAbove() const override;
+    bool isKeepBelow() const override;
+
+    bool isCloseable() const override;
+    bool isMaximizeable() const override;
+    bool isMinimizeable() const override;
+    bool providesContextHelp() const override;
+    bool isModal() const override;
+    bool isShadeable() const override;
+    bool isMoveable() const override;
+    bool isResizeable() const override;
+
+    WId windowId() const override;
+    WId decorationId() const override;
+
+    int width() const override;
+    int height() const override;
+    QSize size() const override;
+    QPalette palette() const override;
+    Qt::Edges adjacentScreenEdges() const override;
+    // Pure virtual only in newer KDecoration2 releases.
+    QString windowClass() const;
+
+    void requestShowToolTip(const QString &text) override;
+    void requestHideToolTip() override;
+    void requestClose() override;
+    void requestToggleMaximization(Qt::MouseButtons buttons) override;
+    void requestMinimize() override;
+    void requestContextHelp() override;
+    void requestToggleOnAllDesktops() override;
+    void requestToggleShade() override;
+    void requestToggleKeepAbove() override;
+    void requestToggleKeepBelow() override;
+
+    // The signature changed between KDecoration2 releases, one of the two
+    // overrides the pure virtual.
+    void requestShowWindowMenu();
+    void requestShowWindowMenu(const QRect &rect);
+
+    void setActive(bool active);
+    void setCaption(const QString &caption);
+    void setMaximized(bool maximized);
+    void setSize(const QSize &size);
+    void setAdjacentScreenEdges(Qt::Edges edges);
+
+private:
+    bool m_active = true;
+    QString m_caption;
+    bool m_maximized = false;
+    QSize m_size = QSize(800, 600);
+    Qt::Edges m_edges;
+};
+
+#endif
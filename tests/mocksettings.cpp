@@ -0,0 +1,59 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "mocksettings.h"
+
+MockSettings::MockSettings(KDecoration2::DecorationSettings *parent)
+    : KDecoration2::DecorationSettingsPrivate(parent)
+{
+}
+
+bool MockSettings::isAlphaChannelSupported() const
+{
+    return true;
+}
+
+bool MockSettings::isOnAllDesktopsAvailable() const
+{
+    return true;
+}
+
+bool MockSettings::isCloseOnDoubleClickOnMenu() const
+{
+    return false;
+}
+
+// The layout config/kwinrc ships, ButtonsOnRight=HIAX.
+QVector<KDecoration2::DecorationButtonType> MockSettings::decorationButtonsLeft() const
+{
+    return {};
+}
+
+QVector<KDecoration2::DecorationButtonType> MockSettings::decorationButtonsRight() const
+{
+    return { KDecoration2::DecorationButtonType::ContextHelp,
+             KDecoration2::DecorationButtonType::Minimize,
+             KDecoration2::DecorationButtonType::Maximize,
+             KDecoration2::DecorationButtonType::Close };
+}
+
+KDecoration2::BorderSize MockSettings::borderSize() const
+{
+    return KDecoration2::BorderSize::Normal;
+}
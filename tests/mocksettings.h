@@ -0,0 +1,38 @@
+/*
+ *   Copyright © 2021 Reion Wong <reionwong@gmail.com>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; see the file COPYING.  if not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MOCKSETTINGS_H
+#define MOCKSETTINGS_H
+
+#include <KDecoration2/Private/DecorationSettingsPrivate>
+
+class MockSettings : public KDecoration2::DecorationSettingsPrivate
+{
+public:
+    explicit MockSettings(KDecoration2::DecorationSettings *parent);
+
+    bool isAlphaChannelSupported() const override;
+    bool isOnAllDesktopsAvailable() const override;
+    bool isCloseOnDoubleClickOnMenu() const override;
+    QVector<KDecoration2::DecorationButtonType> decorationButtonsLeft() const override;
+    QVector<KDecoration2::DecorationButtonType> decorationButtonsRight() const override;
+    KDecoration2::BorderSize borderSize() const override;
+};
+
+#endif